@@ -116,7 +116,7 @@ static phase_codes_t attack(command_t command) {
 			return GO_MOVE;
 		}
 		state_change(DRAGON, DRAGON_DEAD);
-		game.objects[RUG].prop = RUG_FLOOR;
+		ZSET(game.objects[RUG].prop, RUG_FLOOR);
 		/* Hardcoding LOC_SECRET5 as the dragon's death location is
 		 * ugly. The way it was computed before was worse; it depended
 		 * on the two dragon locations being LOC_SECRET4 and LOC_SECRET6
@@ -133,7 +133,7 @@ static phase_codes_t attack(command_t command) {
 				move(i, LOC_SECRET5);
 			}
 		}
-		game.loc = LOC_SECRET5;
+		ZSET(game.loc, LOC_SECRET5);
 		return GO_MOVE;
 	}
 
@@ -148,8 +148,8 @@ static phase_codes_t attack(command_t command) {
 		for (int i = 1; i < PIRATE; i++) {
 			if (game.dwarves[i].loc == game.loc) {
 				++dwarves;
-				game.dwarves[i].loc = LOC_LONGWEST;
-				game.dwarves[i].seen = false;
+				ZSET(game.dwarves[i].loc, LOC_LONGWEST);
+				ZSET(game.dwarves[i].seen, false);
 			}
 		}
 		rspeak((dwarves > 1) ? OGRE_PANIC1 : OGRE_PANIC2);
@@ -202,12 +202,12 @@ static phase_codes_t bigwords(vocab_t id) {
 	if ((foobar == WORD_EMPTY && id == FEE) ||
 	    (foobar == FEE && id == FIE) || (foobar == FIE && id == FOE) ||
 	    (foobar == FOE && id == FOO)) {
-		game.foobar = id;
+		ZSET(game.foobar, id);
 		if (id != FOO) {
 			rspeak(OK_MAN);
 			return GO_CLEAROBJ;
 		}
-		game.foobar = WORD_EMPTY;
+		ZSET(game.foobar, WORD_EMPTY);
 		if (game.objects[EGGS].place == objects[EGGS].plac ||
 		    (TOTING(EGGS) && game.loc == objects[EGGS].plac)) {
 			rspeak(NOTHING_HAPPENS);
@@ -218,7 +218,7 @@ static phase_codes_t bigwords(vocab_t id) {
 			if (game.objects[EGGS].place == LOC_NOWHERE &&
 			    game.objects[TROLL].place == LOC_NOWHERE &&
 			    game.objects[TROLL].prop == TROLL_UNPAID) {
-				game.objects[TROLL].prop = TROLL_PAIDONCE;
+				ZSET(game.objects[TROLL].prop, TROLL_PAIDONCE);
 			}
 			if (HERE(EGGS)) {
 				pspeak(EGGS, look, true, EGGS_VANISHED);
@@ -238,7 +238,7 @@ static phase_codes_t bigwords(vocab_t id) {
 		} else {
 			rspeak(WELL_POINTLESS);
 		}
-		game.foobar = WORD_EMPTY;
+		ZSET(game.foobar, WORD_EMPTY);
 		return GO_CLEAROBJ;
 	}
 }
@@ -250,13 +250,13 @@ static void blast(void) {
 		rspeak(REQUIRES_DYNAMITE);
 	} else {
 		if (HERE(ROD2)) {
-			game.bonus = splatter;
+			ZSET(game.bonus, splatter);
 			rspeak(SPLATTER_MESSAGE);
 		} else if (game.loc == LOC_NE) {
-			game.bonus = defeat;
+			ZSET(game.bonus, defeat);
 			rspeak(DEFEAT_MESSAGE);
 		} else {
-			game.bonus = victory;
+			ZSET(game.bonus, victory);
 			rspeak(VICTORY_MESSAGE);
 		}
 		terminate(endgame);
@@ -281,7 +281,7 @@ static phase_codes_t vbreak(verb_t verb, obj_t obj) {
 				drop(VASE, game.loc);
 			}
 			state_change(VASE, VASE_BROKEN);
-			game.objects[VASE].fixed = IS_FIXED;
+			ZSET(game.objects[VASE].fixed, IS_FIXED);
 			break;
 		}
 	/* FALLTHRU */
@@ -294,8 +294,8 @@ static phase_codes_t vbreak(verb_t verb, obj_t obj) {
 static phase_codes_t brief(void) {
 	/*  Brief.  Intransitive only.  Suppress full descriptions after first
 	 * time. */
-	game.abbnum = 10000;
-	game.detail = 3;
+	ZSET(game.abbnum, 10000);
+	ZSET(game.detail, 3);
 	rspeak(BRIEF_CONFIRM);
 	return GO_CLEAROBJ;
 }
@@ -403,7 +403,7 @@ static phase_codes_t vcarry(verb_t verb, obj_t obj) {
 			rspeak(BIRD_EVADES);
 			return GO_CLEAROBJ;
 		}
-		game.objects[BIRD].prop = BIRD_CAGED;
+		ZSET(game.objects[BIRD].prop, BIRD_CAGED);
 	}
 	if ((obj == BIRD || obj == CAGE) &&
 	    OBJECT_STATE_EQUALS(BIRD, BIRD_CAGED)) {
@@ -414,12 +414,12 @@ static phase_codes_t vcarry(verb_t verb, obj_t obj) {
 	carry(obj, game.loc);
 
 	if (obj == BOTTLE && LIQUID() != NO_OBJECT) {
-		game.objects[LIQUID()].place = CARRIED;
+		ZSET(game.objects[LIQUID()].place, CARRIED);
 	}
 
 	if (GSTONE(obj) && !OBJECT_IS_FOUND(obj)) {
 		OBJECT_SET_FOUND(obj);
-		game.objects[CAVITY].prop = CAVITY_EMPTY;
+		ZSET(game.objects[CAVITY].prop, CAVITY_EMPTY);
 	}
 	rspeak(OK_MAN);
 	return GO_CLEAROBJ;
@@ -436,10 +436,10 @@ static int chain(verb_t verb) {
 			rspeak(ALREADY_UNLOCKED);
 			return GO_CLEAROBJ;
 		}
-		game.objects[CHAIN].prop = CHAIN_HEAP;
-		game.objects[CHAIN].fixed = IS_FREE;
+		ZSET(game.objects[CHAIN].prop, CHAIN_HEAP);
+		ZSET(game.objects[CHAIN].fixed, IS_FREE);
 		if (game.objects[BEAR].prop != BEAR_DEAD) {
-			game.objects[BEAR].prop = CONTENTED_BEAR;
+			ZSET(game.objects[BEAR].prop, CONTENTED_BEAR);
 		}
 
 		switch (game.objects[BEAR].prop) {
@@ -448,11 +448,11 @@ static int chain(verb_t verb) {
 			/* Can't be reached until the bear can die in some way
 			 * other than a bridge collapse. Leave in in case this
 			 * changes, but exclude from coverage testing. */
-			game.objects[BEAR].fixed = IS_FIXED;
+			ZSET(game.objects[BEAR].fixed, IS_FIXED);
 			break;
 		// LCOV_EXCL_STOP
 		default:
-			game.objects[BEAR].fixed = IS_FREE;
+			ZSET(game.objects[BEAR].fixed, IS_FREE);
 		}
 		rspeak(CHAIN_UNLOCKED);
 		return GO_CLEAROBJ;
@@ -467,12 +467,12 @@ static int chain(verb_t verb) {
 		return GO_CLEAROBJ;
 	}
 
-	game.objects[CHAIN].prop = CHAIN_FIXED;
+	ZSET(game.objects[CHAIN].prop, CHAIN_FIXED);
 
 	if (TOTING(CHAIN)) {
 		drop(CHAIN, game.loc);
 	}
-	game.objects[CHAIN].fixed = IS_FIXED;
+	ZSET(game.objects[CHAIN].fixed, IS_FIXED);
 
 	rspeak(CHAIN_LOCKED);
 	return GO_CLEAROBJ;
@@ -494,8 +494,8 @@ static phase_codes_t discard(verb_t verb, obj_t obj) {
 	if (GSTONE(obj) && AT(CAVITY) &&
 	    game.objects[CAVITY].prop != CAVITY_FULL) {
 		rspeak(GEM_FITS);
-		game.objects[obj].prop = STATE_IN_CAVITY;
-		game.objects[CAVITY].prop = CAVITY_FULL;
+		ZSET(game.objects[obj].prop, STATE_IN_CAVITY);
+		ZSET(game.objects[CAVITY].prop, CAVITY_FULL);
 		if (HERE(RUG) &&
 		    ((obj == EMERALD && game.objects[RUG].prop != RUG_HOVER) ||
 		     (obj == RUBY && game.objects[RUG].prop == RUG_HOVER))) {
@@ -510,7 +510,7 @@ static phase_codes_t discard(verb_t verb, obj_t obj) {
 				int k = (game.objects[RUG].prop == RUG_HOVER)
 				            ? RUG_FLOOR
 				            : RUG_HOVER;
-				game.objects[RUG].prop = k;
+				ZSET(game.objects[RUG].prop, k);
 				if (k == RUG_HOVER) {
 					k = objects[SAPPH].plac;
 				}
@@ -532,7 +532,7 @@ static phase_codes_t discard(verb_t verb, obj_t obj) {
 		obj = BOTTLE;
 	}
 	if (obj == BOTTLE && LIQUID() != NO_OBJECT) {
-		game.objects[LIQUID()].place = LOC_NOWHERE;
+		ZSET(game.objects[LIQUID()].place, LOC_NOWHERE);
 	}
 
 	if (obj == BEAR && AT(TROLL)) {
@@ -551,7 +551,7 @@ static phase_codes_t discard(verb_t verb, obj_t obj) {
 			state_change(VASE,
 			             AT(PILLOW) ? VASE_WHOLE : VASE_DROPPED);
 			if (game.objects[VASE].prop != VASE_WHOLE) {
-				game.objects[VASE].fixed = IS_FIXED;
+				ZSET(game.objects[VASE].fixed, IS_FIXED);
 			}
 			drop(obj, game.loc);
 			return GO_CLEAROBJ;
@@ -575,13 +575,13 @@ static phase_codes_t discard(verb_t verb, obj_t obj) {
 			}
 			DESTROY(SNAKE);
 			/* Set game.prop for use by travel options */
-			game.objects[SNAKE].prop = SNAKE_CHASED;
+			ZSET(game.objects[SNAKE].prop, SNAKE_CHASED);
 		} else {
 			rspeak(OK_MAN);
 		}
 
-		game.objects[BIRD].prop =
-		    FOREST(game.loc) ? BIRD_FOREST_UNCAGED : BIRD_UNCAGED;
+		ZSET(game.objects[BIRD].prop,
+		     FOREST(game.loc) ? BIRD_FOREST_UNCAGED : BIRD_UNCAGED);
 		drop(obj, game.loc);
 		return GO_CLEAROBJ;
 	}
@@ -603,7 +603,7 @@ static phase_codes_t drink(verb_t verb, obj_t obj) {
 	if (obj == BLOOD) {
 		DESTROY(BLOOD);
 		state_change(DRAGON, DRAGON_BLOODLESS);
-		game.blooded = true;
+		ZSET(game.blooded, true);
 		return GO_CLEAROBJ;
 	}
 
@@ -612,7 +612,7 @@ static phase_codes_t drink(verb_t verb, obj_t obj) {
 		return GO_CLEAROBJ;
 	}
 	if (LIQUID() == WATER && HERE(BOTTLE)) {
-		game.objects[WATER].place = LOC_NOWHERE;
+		ZSET(game.objects[WATER].place, LOC_NOWHERE);
 		state_change(BOTTLE, EMPTY_BOTTLE);
 		return GO_CLEAROBJ;
 	}
@@ -715,7 +715,7 @@ static phase_codes_t feed(verb_t verb, obj_t obj) {
 		break;
 	case DWARF:
 		if (HERE(FOOD)) {
-			game.dflag += 2;
+			ZSET(game.dflag, game.dflag + 2);
 			rspeak(REALLY_MAD);
 		} else {
 			speak(actions[verb].message);
@@ -729,8 +729,8 @@ static phase_codes_t feed(verb_t verb, obj_t obj) {
 		if (game.objects[BEAR].prop == UNTAMED_BEAR) {
 			if (HERE(FOOD)) {
 				DESTROY(FOOD);
-				game.objects[AXE].fixed = IS_FREE;
-				game.objects[AXE].prop = AXE_HERE;
+				ZSET(game.objects[AXE].fixed, IS_FREE);
+				ZSET(game.objects[AXE].prop, AXE_HERE);
 				state_change(BEAR, SITTING_BEAR);
 			} else {
 				rspeak(NOTHING_EDIBLE);
@@ -765,8 +765,8 @@ phase_codes_t fill(verb_t verb, obj_t obj) {
 			return GO_CLEAROBJ;
 		}
 		rspeak(SHATTER_VASE);
-		game.objects[VASE].prop = VASE_BROKEN;
-		game.objects[VASE].fixed = IS_FIXED;
+		ZSET(game.objects[VASE].prop, VASE_BROKEN);
+		ZSET(game.objects[VASE].fixed, IS_FIXED);
 		drop(VASE, game.loc);
 		return GO_CLEAROBJ;
 	}
@@ -783,12 +783,12 @@ phase_codes_t fill(verb_t verb, obj_t obj) {
 		int k = LIQUID();
 		switch (k) {
 		case WATER:
-			game.objects[BOTTLE].prop = EMPTY_BOTTLE;
+			ZSET(game.objects[BOTTLE].prop, EMPTY_BOTTLE);
 			rspeak(WATER_URN);
 			break;
 		case OIL:
-			game.objects[URN].prop = URN_DARK;
-			game.objects[BOTTLE].prop = EMPTY_BOTTLE;
+			ZSET(game.objects[URN].prop, URN_DARK);
+			ZSET(game.objects[BOTTLE].prop, EMPTY_BOTTLE);
 			rspeak(OIL_URN);
 			break;
 		case NO_OBJECT:
@@ -796,7 +796,7 @@ phase_codes_t fill(verb_t verb, obj_t obj) {
 			rspeak(FILL_INVALID);
 			return GO_CLEAROBJ;
 		}
-		game.objects[k].place = LOC_NOWHERE;
+		ZSET(game.objects[k].place, LOC_NOWHERE);
 		return GO_CLEAROBJ;
 	}
 	if (obj != INTRANSITIVE && obj != BOTTLE) {
@@ -823,7 +823,7 @@ phase_codes_t fill(verb_t verb, obj_t obj) {
 	state_change(BOTTLE,
 	             (LIQLOC(game.loc) == OIL) ? OIL_BOTTLE : WATER_BOTTLE);
 	if (TOTING(BOTTLE)) {
-		game.objects[LIQUID()].place = CARRIED;
+		ZSET(game.objects[LIQUID()].place, CARRIED);
 	}
 	return GO_CLEAROBJ;
 }
@@ -875,14 +875,14 @@ static phase_codes_t fly(verb_t verb, obj_t obj) {
 	}
 
 	if (game.loc == LOC_CLIFF) {
-		game.oldlc2 = game.oldloc;
-		game.oldloc = game.loc;
-		game.newloc = LOC_LEDGE;
+		ZSET(game.oldlc2, game.oldloc);
+		ZSET(game.oldloc, game.loc);
+		ZSET(game.newloc, LOC_LEDGE);
 		rspeak(RUG_GOES);
 	} else if (game.loc == LOC_LEDGE) {
-		game.oldlc2 = game.oldloc;
-		game.oldloc = game.loc;
-		game.newloc = LOC_CLIFF;
+		ZSET(game.oldlc2, game.oldloc);
+		ZSET(game.oldloc, game.loc);
+		ZSET(game.newloc, LOC_CLIFF);
 		rspeak(RUG_RETURNS);
 	} else {
 		// LCOV_EXCL_START
@@ -1035,9 +1035,9 @@ static phase_codes_t lock(verb_t verb, obj_t obj) {
 			if (game.closng) {
 				rspeak(EXIT_CLOSED);
 				if (!game.panic) {
-					game.clock2 = PANICTIME;
+					ZSET(game.clock2, PANICTIME);
 				}
-				game.panic = true;
+				ZSET(game.panic, true);
 			} else {
 				state_change(GRATE, (verb == LOCK)
 				                        ? GRATE_CLOSED
@@ -1110,8 +1110,8 @@ static phase_codes_t pour(verb_t verb, obj_t obj) {
 	if (HERE(URN) && game.objects[URN].prop == URN_EMPTY) {
 		return fill(verb, URN);
 	}
-	game.objects[BOTTLE].prop = EMPTY_BOTTLE;
-	game.objects[obj].place = LOC_NOWHERE;
+	ZSET(game.objects[BOTTLE].prop, EMPTY_BOTTLE);
+	ZSET(game.objects[obj].place, LOC_NOWHERE);
 	if (!(AT(PLANT) || AT(DOOR))) {
 		rspeak(GROUND_WET);
 		return GO_CLEAROBJ;
@@ -1121,7 +1121,7 @@ static phase_codes_t pour(verb_t verb, obj_t obj) {
 			/* cycle through the three plant states */
 			state_change(PLANT,
 			             MOD(game.objects[PLANT].prop + 1, 3));
-			game.objects[PLANT2].prop = game.objects[PLANT].prop;
+			ZSET(game.objects[PLANT2].prop, game.objects[PLANT].prop);
 			return GO_MOVE;
 		} else {
 			rspeak(SHAKING_LEAVES);
@@ -1166,9 +1166,10 @@ static phase_codes_t read(command_t command)
 		if (!TOTING(OYSTER) || !game.closed) {
 			rspeak(DONT_UNDERSTAND);
 		} else if (!game.clshnt) {
-			game.clshnt = yes_or_no(arbitrary_messages[CLUE_QUERY],
-			                        arbitrary_messages[WAYOUT_CLUE],
-			                        arbitrary_messages[OK_MAN]);
+			bool clue = yes_or_no(arbitrary_messages[CLUE_QUERY],
+			                      arbitrary_messages[WAYOUT_CLUE],
+			                      arbitrary_messages[OK_MAN]);
+			ZSET(game.clshnt, clue);
 		} else {
 			pspeak(OYSTER, hear, true,
 			       1); // Not really a sound, but oh well.
@@ -1195,8 +1196,8 @@ static phase_codes_t reservoir(void) {
 		if (AT(RESER)) {
 			return GO_CLEAROBJ;
 		} else {
-			game.oldlc2 = game.loc;
-			game.newloc = LOC_NOWHERE;
+			ZSET(game.oldlc2, game.loc);
+			ZSET(game.newloc, LOC_NOWHERE);
 			rspeak(NOT_BRIGHT);
 			return GO_TERMINATE;
 		}
@@ -1208,8 +1209,8 @@ static phase_codes_t rub(verb_t verb, obj_t obj) {
 	if (obj == URN && game.objects[URN].prop == URN_LIT) {
 		DESTROY(URN);
 		drop(AMBER, game.loc);
-		game.objects[AMBER].prop = AMBER_IN_ROCK;
-		--game.tally;
+		ZSET(game.objects[AMBER].prop, AMBER_IN_ROCK);
+		ZSET(game.tally, game.tally - 1);
 		drop(CAVITY, game.loc);
 		rspeak(URN_GENIES);
 	} else if (obj != LAMP) {
@@ -1291,7 +1292,7 @@ static phase_codes_t throwit(command_t command) {
 				/* This'll teach him to throw the axe at the
 				 * bear! */
 				drop(AXE, game.loc);
-				game.objects[AXE].fixed = IS_FIXED;
+				ZSET(game.objects[AXE].fixed, IS_FIXED);
 				juggle(BEAR);
 				state_change(AXE, AXE_LOST);
 				return GO_CLEAROBJ;
@@ -1304,10 +1305,11 @@ static phase_codes_t throwit(command_t command) {
 			return throw_support(DWARF_DODGES);
 		} else {
 			int i = atdwrf(game.loc);
-			game.dwarves[i].seen = false;
-			game.dwarves[i].loc = LOC_NOWHERE;
-			return throw_support(
-			    (++game.dkill == 1) ? DWARF_SMOKE : KILLED_DWARF);
+			ZSET(game.dwarves[i].seen, false);
+			ZSET(game.dwarves[i].loc, LOC_NOWHERE);
+			ZSET(game.dkill, game.dkill + 1);
+			return throw_support(game.dkill == 1 ? DWARF_SMOKE
+			                                     : KILLED_DWARF);
 		}
 	}
 }
@@ -1328,13 +1330,16 @@ static phase_codes_t seed(verb_t verb, const char *arg) {
 	int32_t seed = strtol(arg, NULL, 10);
 	speak(actions[verb].message, seed);
 	set_seed(seed);
-	--game.turns;
+	if (settings.transcript != NULL) {
+		settings.transcript->seeded = true;
+	}
+	ZSET(game.turns, game.turns - 1);
 	return GO_TOP;
 }
 
 static phase_codes_t waste(verb_t verb, turn_t turns) {
 	/* Burn turns */
-	game.limit -= turns;
+	ZSET(game.limit, game.limit - turns);
 	speak(actions[verb].message, (int)game.limit);
 	return GO_TOP;
 }
@@ -1353,7 +1358,7 @@ static phase_codes_t wave(verb_t verb, obj_t obj) {
 	    game.loc == game.objects[STEPS].place && OBJECT_IS_NOTFOUND(JADE)) {
 		drop(JADE, game.loc);
 		OBJECT_SET_FOUND(JADE);
-		--game.tally;
+		ZSET(game.tally, game.tally - 1);
 		rspeak(NECKLACE_FLY);
 		return GO_CLEAROBJ;
 	} else {
@@ -1390,6 +1395,7 @@ phase_codes_t action(command_t command) {
 	 * further were called "specials". Now they're handled here as normal
 	 * actions. If noaction is true, then we spit out the message and return
 	 */
+	stats_count(settings.stats, STATS_VERB, command.verb);
 	if (actions[command.verb].noaction) {
 		speak(actions[command.verb].message);
 		return GO_CLEAROBJ;
@@ -1420,7 +1426,7 @@ phase_codes_t action(command_t command) {
 			command.obj = PLANT2;
 			/* FALL THROUGH */;
 		} else if (command.obj == KNIFE && game.knfloc == game.loc) {
-			game.knfloc = -1;
+			ZSET(game.knfloc, -1);
 			rspeak(KNIVES_VANISH);
 			return GO_CLEAROBJ;
 		} else if (command.obj == ROD && HERE(ROD2)) {
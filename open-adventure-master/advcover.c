@@ -0,0 +1,159 @@
+/*
+ * 'advcover' merges the coverage records advent -C sessions append to
+ * coverage files and prints how many sessions reached each item of
+ * dungeon content, one per line:
+ *
+ *	group index sessions name
+ *
+ * followed by a summary line per group.  Unreached items are left out
+ * unless -a is given; -u prints only those.  Any number of files may
+ * be named, and each may hold any number of sessions.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *group_names[COVER_GROUPS] = {
+    [COVER_LOCATION] = "location",
+    [COVER_TRAVEL] = "travel",
+    [COVER_MESSAGE] = "message",
+    [COVER_STATE] = "state",
+};
+
+static const int group_size[COVER_GROUPS] = {
+    [COVER_LOCATION] = NLOCATIONS + 1,
+    [COVER_TRAVEL] = NTRAVEL,
+    [COVER_MESSAGE] = NARBITRARY,
+    [COVER_STATE] = (NOBJECTS + 1) * (MAX_STATE + 1),
+};
+
+static uint64_t counts[COVER_BITS];
+static loc_t travel_from[NTRAVEL]; // the location owning each entry
+
+static const char *first_word(const string_group_t *words) {
+	return words->n > 0 ? words->strs[0] : "-";
+}
+
+static void name(char *buf, size_t size, enum covergroup group, int i) {
+	const char *text;
+
+	switch (group) {
+	case COVER_LOCATION:
+		text = locations[i].description.small;
+		snprintf(buf, size, "%.60s", text != NULL ? text : "-");
+		break;
+	case COVER_TRAVEL:
+		snprintf(buf, size, "from %d %s", travel_from[i],
+		         first_word(&motions[travel[i].motion].words));
+		break;
+	case COVER_MESSAGE:
+		text = arbitrary_messages[i];
+		if (text == NULL) {
+			text = "-";
+		}
+		snprintf(buf, size, "%.*s", (int)strcspn(text, "\n"), text);
+		break;
+	case COVER_STATE:
+		snprintf(buf, size, "%s %d",
+		         first_word(&objects[i / (MAX_STATE + 1)].words),
+		         i % (MAX_STATE + 1));
+		break;
+	default:
+		snprintf(buf, size, "-"); // LCOV_EXCL_LINE
+	}
+}
+
+static bool add_file(const char *path, uint64_t *sessions) {
+	/* Count every record in one coverage file. */
+	FILE *fp = fopen(path, "rb");
+	struct coverage_t cover;
+	int status;
+
+	if (fp == NULL) {
+		perror(path);
+		return false;
+	}
+	while ((status = coverage_load(&cover, fp)) == 1) {
+		(*sessions)++;
+		for (size_t w = 0; w < sizeof(cover.bits) / sizeof(cover.bits[0]);
+		     w++) {
+			for (uint64_t bits = cover.bits[w]; bits != 0;
+			     bits &= bits - 1) {
+				counts[w * 64 + __builtin_ctzll(bits)]++;
+			}
+		}
+	}
+	fclose(fp);
+	if (status < 0) {
+		fprintf(stderr, "%s: not a coverage file for this dungeon\n",
+		        path);
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	bool all = false, unreached = false;
+	uint64_t sessions = 0;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "au")) != EOF) {
+		switch (ch) {
+		case 'a':
+			all = true;
+			break;
+		case 'u':
+			unreached = true;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-a] [-u] coverfile...\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (optind >= argc) {
+		fprintf(stderr, "Usage: %s [-a] [-u] coverfile...\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	for (int i = optind; i < argc; i++) {
+		if (!add_file(argv[i], &sessions)) {
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (loc_t loc = 1; loc <= NLOCATIONS; loc++) {
+		int kk = tkey[loc];
+		if (kk == 0) {
+			continue;
+		}
+		do {
+			travel_from[kk] = loc;
+		} while (!travel[kk++].stop);
+	}
+
+	int reached[COVER_GROUPS] = {0};
+	for (int g = 0; g < COVER_GROUPS; g++) {
+		for (int i = 0; i < group_size[g]; i++) {
+			uint64_t count = counts[coverage_index(g, i)];
+			reached[g] += count != 0;
+			if (unreached ? count == 0 : count != 0 || all) {
+				char text[LINESIZE];
+				name(text, sizeof(text), g, i);
+				printf("%s %d %" PRIu64 " %s\n", group_names[g], i,
+				       count, text);
+			}
+		}
+	}
+	for (int g = 0; g < COVER_GROUPS; g++) {
+		printf("# %s: %d of %d reached in %" PRIu64 " sessions\n",
+		       group_names[g], reached[g], group_size[g], sessions);
+	}
+	return EXIT_SUCCESS;
+}
+
+/* end */
@@ -5,10 +5,13 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 #include <inttypes.h>
+#include <setjmp.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "dungeon.h"
 
@@ -71,12 +74,13 @@
  */
 #define OBJECT_IS_NOTFOUND(obj) (game.objects[obj].prop == STATE_NOTFOUND)
 #define OBJECT_IS_FOUND(obj) (game.objects[obj].prop == STATE_FOUND)
-#define OBJECT_SET_FOUND(obj) (game.objects[obj].prop = STATE_FOUND)
-#define OBJECT_SET_NOT_FOUND(obj) (game.objects[obj].prop = STATE_NOTFOUND)
+#define OBJECT_SET_FOUND(obj) ZSET(game.objects[obj].prop, STATE_FOUND)
+#define OBJECT_SET_NOT_FOUND(obj) ZSET(game.objects[obj].prop, STATE_NOTFOUND)
 #define OBJECT_IS_NOTFOUND2(g, o) (g.objects[o].prop == STATE_NOTFOUND)
 #define PROP_IS_INVALID(val) (val < -MAX_STATE - 1 || val > MAX_STATE)
 #define PROP_STASHIFY(n) (-1 - (n))
-#define OBJECT_STASHIFY(obj, pval) game.objects[obj].prop = PROP_STASHIFY(pval)
+#define OBJECT_STASHIFY(obj, pval)                                             \
+	ZSET(game.objects[obj].prop, PROP_STASHIFY(pval))
 #define OBJECT_IS_STASHED(obj) (game.objects[obj].prop < STATE_NOTFOUND)
 #define OBJECT_STATE_EQUALS(obj, pval)                                         \
 	((game.objects[obj].prop == pval) ||                                   \
@@ -124,6 +128,34 @@
 	(!CNDBIT(game.loc, COND_LIT) &&                                        \
 	 (game.objects[LAMP].prop == LAMP_DARK || !HERE(LAMP)))
 #define PCT(N) (randrange(100) < (N))
+
+/*
+ * Static tracepoints, compiled in with -DADVENT_USDT ("make usdt") and
+ * otherwise nothing at all.  Provider "advent"; probes and arguments:
+ *	turn__start	turns, loc		do_command() entry
+ *	turn__end	turns, loc		do_command() exit
+ *	command		type1, id1, type2, id2	parsed command words
+ *	move		from, to		location change in do_move()
+ *	carry		object, from		carry()
+ *	drop		object, where		drop()
+ *	state__change	object, state		state_change()
+ *	dwarf__attack	attackers, hits		knives thrown in dwarfmove()
+ *	death		cause, numdie, loc	croak(); enum deathcause
+ *	save		turns			savefile()
+ *	restore		turns			restore() succeeded
+ * e.g. bpftrace -e 'usdt:./advent:advent:move { @[arg1] = count(); }'
+ */
+#if defined ADVENT_USDT
+#include <sys/sdt.h>
+#define PROBE(...) STAP_PROBEV(advent, __VA_ARGS__)
+#else
+#define PROBE(...)                                                             \
+	do {                                                                   \
+	} while (0)
+#endif
+
+/* Random draws note their call site for the -d trace */
+#define randrange(range) randrange_at((range), __func__, __LINE__)
 #define GSTONE(OBJ)                                                            \
 	((OBJ) == EMERALD || (OBJ) == RUBY || (OBJ) == AMBER || (OBJ) == SAPPH)
 #define FOREST(LOC) CNDBIT(LOC, COND_FOREST)
@@ -142,6 +174,8 @@ enum bugtype {
 	HINT_NUMBER_EXCEEDS_GOTO_LIST,
 	SPEECHPART_NOT_TRANSITIVE_OR_INTRANSITIVE_OR_UNKNOWN,
 	ACTION_RETURNED_PHASE_CODE_BEYOND_END_OF_SWITCH,
+	ZOBRIST_HASH_OUT_OF_STEP_WITH_GAME_STATE,
+	OBSERVATION_OUT_OF_STEP_WITH_GAME_STATE,
 };
 
 enum speaktype { touch, look, hear, study, change };
@@ -176,7 +210,88 @@ typedef int32_t loc_t;    // index into the locations array */
 typedef int32_t turn_t;   // turn counter or threshold */
 typedef int32_t bool32_t; // turn counter or threshold */
 
+/*
+ * Live game state.  Fields are as narrow as their ranges allow so that
+ * many sessions fit in cache: locations and most counters are 16 bits,
+ * object-list heads and links 8 bits (NOBJECTS * 2 must stay below 256),
+ * flags are plain bools.  Counters a player or cheat can drive without
+ * bound stay 32 bits.  Arrays go last; struct snapshot_t relies on it.
+ */
 struct game_t {
+	int32_t lcg_x;
+	int32_t conds;  // min value for cond[loc] if loc has any hints
+	int32_t detail; // level of detail in descriptions
+	int32_t igo;    // # uses of "go" instead of a direction
+	int32_t iwest;  // # times he's said "west" instead of "w"
+	int32_t saved;  // point penalty for saves
+	turn_t limit;   // lifetime of lamp
+	turn_t numdie;  // number of times killed so far
+	turn_t trnluz;  // # points lost so far due to turns used
+	turn_t turns;   // counts commands given (ignores yes/no)
+	int16_t abbnum; // How often to print int descriptions
+	int16_t chloc;  // pirate chest location
+	int16_t chloc2; // pirate chest alternate location
+	int16_t clock1; // # turns from finding last treasure to close
+	int16_t clock2; // # turns from warning till blinding flash
+
+	/*  dflag controls the level of activation of dwarves:
+	 *	0	No dwarf stuff yet (wait until reaches Hall Of Mists)
+	 *	1	Reached Hall Of Mists, but hasn't met first dwarf
+	 *	2	Met 1t dwarf, others start moving, no knives thrown yet
+	 *      3	A knife has been thrown (first set always misses) 3+
+	 * Dwarves are mad (increases their accuracy) */
+	int16_t dflag;
+
+	int16_t dkill;  // dwarves killed
+	int16_t dtotal; // total dwarves (including pirate) in loc
+	int16_t foobar; // progress in saying "FEE FIE FOE FOO".
+	int16_t holdng; // number of objects being carried
+	int16_t knfloc; // knife location; LOC_NOWERE if none, -1 after caveat
+	int16_t loc;    // where player is now
+	int16_t newloc; // where player is going
+	int16_t oldloc; // where player was
+	int16_t oldlc2; // where player was two moves ago
+	int16_t oldobj; // last object player handled
+	int16_t tally;  // count of treasures gained
+	int16_t thresh; // current threshold for endgame scoring tier
+	char zzword[TOKLEN + 1]; // randomly generated magic word from bird
+	uint8_t bonus;     // What kind of finishing bonus we are getting
+	bool clshnt;       // has player read the clue in the endgame?
+	bool closed;       // whether we're all the way closed
+	bool closng;       // whether it's closing time yet
+	bool lmwarn;       // has player been warned about lamp going dim?
+	bool novice;       // asked for instructions at start-up?
+	bool panic;        // has player found out he's trapped?
+	bool wzdark;       // whether the loc he's leaving was dark
+	bool blooded;      // has player drunk of dragon's blood?
+	bool seenbigwords; // have we red the graffiti in the Giant's Room?
+	struct {
+		uint16_t abbrev; // has location been seen? (wraps at 65536)
+		uint8_t atloc;   // head of object linked list per location
+	} locs[NLOCATIONS + 1];
+	struct {
+		bool seen;      // true if dwarf has seen him
+		int16_t loc;    // location of dwarves, initially hard-wired in
+		int16_t oldloc; // prior loc of each dwarf, initially garbage
+	} dwarves[NDWARVES + 1];
+	struct {
+		int16_t fixed; // fixed location of object (if not IS_FREE)
+		int16_t place; // location of object
+		int8_t prop;   // object state
+	} objects[NOBJECTS + 1];
+	struct {
+		bool used;  // hints[i].used = true iff hint i has been used.
+		int32_t lc; // hints[i].lc = show int at LOC with cond bit i
+	} hints[NHINTS];
+	uint8_t link[NOBJECTS * 2 + 1]; // object-list links
+};
+
+/*
+ * The same state in its original all-32-bit layout.  This is what goes
+ * into save files, so the format does not depend on struct game_t;
+ * savefile() and restore() convert between the two.
+ */
+struct savegame_t {
 	int32_t lcg_x;
 	int32_t abbnum;   // How often to print int descriptions
 	score_t bonus;    // What kind of finishing bonus we are getting
@@ -245,19 +360,297 @@ struct game_t {
 	obj_t link[NOBJECTS * 2 + 1]; // object-list links
 };
 
+/*
+ * Copy-on-write snapshot of struct game_t.  Scalars up to locs[] are
+ * held inline; each array section is a shared, reference-counted chunk.
+ * See snapshot.c.
+ */
+enum snapsection {
+	SNAP_LOCS,
+	SNAP_DWARVES,
+	SNAP_OBJECTS,
+	SNAP_HINTS,
+	SNAP_LINK,
+	SNAP_SECTIONS
+};
+
+struct snapshot_t {
+	struct snapchunk_t *chunk[SNAP_SECTIONS];
+	unsigned char head[offsetof(struct game_t, locs)];
+	uint64_t zobrist; // game_zobrist when taken
+	bool rehash;      // a section was written since; zobrist is stale
+};
+
+/*
+ * Binary command log, buffered per session.  See cmdlog.c for the format.
+ */
+struct cmdlog_t {
+	FILE *fp;
+	size_t len;  // bytes pending in buf
+	int records; // records since last flush
+	turn_t turn; // turn of the last record
+	unsigned char buf[4096];
+};
+
+/*
+ * Turn phases timed by the -T profiler.  See profile.c.
+ */
+enum phase {
+	PHASE_MOVE,
+	PHASE_DWARFMOVE,
+	PHASE_DESCRIBE,
+	PHASE_LISTOBJECTS,
+	PHASE_CHECKHINTS,
+	PHASE_TOKENIZE,
+	PHASE_ACTION,
+	PHASE_LAMPCHECK,
+	PHASE_CLOSECHECK,
+	PHASE_OUTPUT,
+	PHASE_COUNT
+};
+
+/*
+ * Gameplay counters shared by every session on a host through a
+ * memory-mapped file.  See stats.c for the layout.
+ */
+enum statgroup {
+	STATS_GAMES,        // one counter: sessions started
+	STATS_VERB,         // by action verb
+	STATS_MOTION,       // by motion word
+	STATS_VISIT,        // entries into each location
+	STATS_DEATH,        // by enum deathcause
+	STATS_HINT_OFFERED, // by hint
+	STATS_HINT_USED,    // by hint
+	STATS_GROUPS
+};
+
+enum deathcause {
+	DEATH_DWARF,  // killed by a dwarf's knife
+	DEATH_TRAVEL, // walked somewhere fatal
+	DEATH_PIT,    // fell into a pit in the dark
+	DEATH_BRIDGE, // took the bear across the troll bridge
+	DEATH_CAUSES
+};
+
+#define STATS_CACHELINE 64
+
+struct statcounter_t {
+	uint64_t count;
+	unsigned char pad[STATS_CACHELINE - sizeof(uint64_t)];
+} __attribute__((aligned(STATS_CACHELINE)));
+
+struct stats_t {
+	char magic[16];
+	uint32_t size[STATS_GROUPS]; // counters in each group
+	struct statcounter_t counter[] __attribute__((aligned(STATS_CACHELINE)));
+};
+
+/*
+ * The last RNGTRACE_SIZE random draws, kept with -d.  See rngtrace.c.
+ */
+#define RNGTRACE_SIZE 4096 // a power of two
+
+struct rngdraw_t {
+	const char *func; // calling function
+	int32_t line;     // and line
+	turn_t turn;
+	int32_t range; // randrange() argument
+	int32_t value; // LCG value consumed
+};
+
+struct rngtrace_t {
+	uint64_t draws; // ever recorded; ring[draws % RNGTRACE_SIZE] is next
+	struct rngdraw_t ring[RNGTRACE_SIZE];
+};
+
+/*
+ * Rolling hash of a session's output and per-prompt records of it,
+ * kept with -H.  See transcript.c for the record format.
+ */
+struct transcript_t {
+	FILE *stream;    // the hashing stream handed out as settings.outfp
+	FILE *dest;      // where output goes after hashing, or NULL
+	FILE *records;   // one line per prompt
+	uint64_t hash;   // FNV-1a of all output so far
+	uint64_t offset; // bytes of output so far
+	int prompts;     // records written
+	bool seeded;     // the seed came from the log or a save, not the clock
+};
+
+/*
+ * Dungeon content a session has reached, kept with -C.  See coverage.c.
+ */
+enum covergroup {
+	COVER_LOCATION, // locations entered
+	COVER_TRAVEL,   // travel-table entries taken
+	COVER_MESSAGE,  // arbitrary messages spoken
+	COVER_STATE,    // object states reached, MAX_STATE + 1 per object
+	COVER_GROUPS
+};
+
+#define COVER_BITS                                                             \
+	(NLOCATIONS + 1 + NTRAVEL + NARBITRARY + (NOBJECTS + 1) * (MAX_STATE + 1))
+
+struct coverage_t {
+	uint64_t bits[(COVER_BITS + 63) / 64];
+};
+
+/*
+ * Many games stepped in lockstep, each struct game_t field kept as one
+ * column across the games.  See batch.c.
+ */
+enum batchcolumn {
+	BATCH_LCG_X,
+	BATCH_CONDS,
+	BATCH_DETAIL,
+	BATCH_IGO,
+	BATCH_IWEST,
+	BATCH_SAVED,
+	BATCH_LIMIT,
+	BATCH_NUMDIE,
+	BATCH_TRNLUZ,
+	BATCH_TURNS,
+	BATCH_ABBNUM,
+	BATCH_CHLOC,
+	BATCH_CHLOC2,
+	BATCH_CLOCK1,
+	BATCH_CLOCK2,
+	BATCH_DFLAG,
+	BATCH_DKILL,
+	BATCH_DTOTAL,
+	BATCH_FOOBAR,
+	BATCH_HOLDNG,
+	BATCH_KNFLOC,
+	BATCH_LOC,
+	BATCH_NEWLOC,
+	BATCH_OLDLOC,
+	BATCH_OLDLC2,
+	BATCH_OLDOBJ,
+	BATCH_TALLY,
+	BATCH_THRESH,
+	BATCH_ZZWORD,
+	BATCH_BONUS,
+	BATCH_CLSHNT,
+	BATCH_CLOSED,
+	BATCH_CLOSNG,
+	BATCH_LMWARN,
+	BATCH_NOVICE,
+	BATCH_PANIC,
+	BATCH_WZDARK,
+	BATCH_BLOODED,
+	BATCH_SEENBIGWORDS,
+	BATCH_ABBREV, // per location
+	BATCH_ATLOC, // per location
+	BATCH_DWARF_SEEN, // per dwarf
+	BATCH_DWARF_LOC, // per dwarf
+	BATCH_DWARF_OLDLOC, // per dwarf
+	BATCH_FIXED, // per object
+	BATCH_PLACE, // per object
+	BATCH_PROP, // per object
+	BATCH_HINT_USED, // per hint
+	BATCH_HINT_LC, // per hint
+	BATCH_LINK, // per object-list link
+	BATCH_COLUMNS
+};
+
+struct batch_t {
+	size_t n;                    // games
+	int nactions;                // commands a game may be given
+	char **actions;              // their text
+	int16_t *motion;             // per action: motion for the vector path, or -1
+	bool *west;                  // per action: spelled "west"
+	int16_t *route;              // first travel entry per location and motion
+	void *column[BATCH_COLUMNS]; // element k of game i at [k * n + i]
+	bool *done;                  // game over; batch_reset() starts another
+	uint8_t *go;                 // scratch: game takes the vector path
+	int16_t *dest;               // scratch: where it is going
+	bool vector;                 // use the vector path where it applies
+	uint64_t steps;              // game-steps taken
+	uint64_t scalar;             // how many of them took the scalar path
+};
+
+/* A field of game i in a batch, as an lvalue of the column's type */
+#define BATCH_AT(b, col, type, k, i) (((type *)(b)->column[col])[(k) * (b)->n + (i)])
+
+/*
+ * A fixed-length numeric view of the live game for agents, kept current
+ * by ZSET() in a buffer the host attaches.  See observe.c.  Object sets
+ * are bitsets over object numbers, 32 to an entry.
+ */
+#define OBS_SETWORDS ((NOBJECTS + 32) / 32)
+enum observation {
+	OBS_LOC,     // game.loc
+	OBS_DARK,    // 1 if the player can't see
+	OBS_LAMP,    // lamp turns left, game.limit
+	OBS_SCORE,   // what the score command would report
+	OBS_DWARVES, // dwarves (not the pirate) at the player's location
+	OBS_PIRATE,  // 1 if the pirate is there
+	OBS_CARRIED, // objects being carried
+	OBS_VISIBLE = OBS_CARRIED + OBS_SETWORDS, // atloc chain here, if lit
+	OBS_PROP = OBS_VISIBLE + OBS_SETWORDS,    // prop of each object
+	OBS_SIZE = OBS_PROP + NOBJECTS + 1,
+};
+
+/*
+ * Commands as compact ids, for valid_actions() (see valid.c): a motion
+ * word, an action verb alone, or a verb applied to an object.
+ */
+#define VALID_MOTION(m) (m)
+#define VALID_VERB(v) (NMOTIONS + (v))
+#define VALID_PAIR(v, o) (NMOTIONS + NACTIONS + (v) * (NOBJECTS + 1) + (o))
+#define VALID_IDS VALID_PAIR(NACTIONS, 0)
+
+/*
+ * Monte-Carlo rollouts from a game, valuing each command worth trying
+ * next (see rollout.c).  A policy is given the valid command ids at a
+ * prompt, with the rollout's game live, and returns the index of the
+ * one to play; left NULL, commands are picked uniformly at random.
+ */
+typedef size_t (*rollout_policy_t)(const int *, size_t, uint32_t *, void *);
+
+struct rollout_t {
+	int rollouts;            // continuations per candidate command
+	int horizon;             // commands played after the candidate
+	int jobs;                // threads
+	int budget;              // milliseconds, or 0 for no limit
+	uint32_t seed;           // for the policy's random numbers
+	rollout_policy_t policy; // or NULL
+	void *context;           // handed to the policy
+};
+
+struct rollout_value_t {
+	int id;          // the candidate, as a VALID_* id
+	int runs;        // rollouts finished within the budget
+	double score;    // mean score at the end of them
+	double survival; // fraction of them with no death
+};
+
 /*
  * Game application settings - settings, but not state of the game, per se.
  * This data is not saved in a saved game.
  */
 struct settings_t {
+	FILE *outfp; // game output; initialise() defaults it to stdout
 	FILE *logfp;
+	struct cmdlog_t *cmdlog;
 	bool oldstyle;
 	bool prompt;
 	char **argv;
 	int argc;
 	int optind;
 	FILE *scriptfp;
-	int debug;
+	struct rngtrace_t *rngtrace; // random draws, or NULL
+	bool interactive; // input is a terminal: don't echo; libedit keeps history
+	jmp_buf *exitjmp; // if set, session_exit() jumps here, not exit()
+	bool profile;     // time turn phases, see profile.c
+	struct stats_t *stats; // shared gameplay counters, or NULL
+	struct transcript_t *transcript; // output and state hashes, or NULL
+	struct coverage_t *coverage; // content reached, or NULL
+	bool (*answer)(const char *); // if set, answers yes/no questions
+	char *(*readline)(const char *); // if set, reads in place of myreadline()
+	bool silent; // print nothing; the game plays exactly as it would
+	void (*heard)(vocab_t); // if set, told of each arbitrary message
+	bool nosave; // refuse save and resume, as an ADVENT_NOSAVE build does
 };
 
 typedef struct {
@@ -307,15 +700,76 @@ struct save_t {
 	char magic[sizeof(ADVENT_MAGIC)];
 	int32_t version;
 	int32_t canary;
-	struct game_t game;
+	struct savegame_t game;
 };
 
-extern struct game_t game;
-extern struct save_t save;
-extern struct settings_t settings;
+/*
+ * Engine state is per thread, so one process can run several games at
+ * once.  A game runs start to finish on the thread that began it.
+ */
+#define THREAD_LOCAL __thread
+
+extern THREAD_LOCAL struct game_t game;
+extern THREAD_LOCAL uint64_t game_zobrist;
+extern THREAD_LOCAL int32_t *game_observation;
+extern void observe_field(const void *, int);
+
+/*
+ * Every write to the live struct game_t goes through ZSET() so that
+ * game_zobrist and any attached observation follow it; see zobrist.c
+ * and observe.c.  A host that overwrites the game wholesale calls
+ * zobrist_rehash() afterwards, which resynchronizes both.
+ */
+static inline uint64_t zobrist_key(size_t word, uint64_t value) {
+	/* splitmix64 of a word's value, perturbed by its position */
+	uint64_t z = value ^ (word + 1) * 0x9e3779b97f4a7c15ULL;
+	z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ z >> 27) * 0x94d049bb133111ebULL;
+	return z ^ z >> 31;
+}
+
+static inline uint64_t zobrist_word(const struct game_t *g, size_t word) {
+	/* The word'th eight bytes of a game, zero-padded past its end */
+	uint64_t value = 0;
+	size_t offset = word * 8;
+	size_t n = sizeof(*g) - offset < 8 ? sizeof(*g) - offset : 8;
+	memcpy(&value, (const unsigned char *)g + offset, n);
+	return value;
+}
+
+static inline void zobrist_toggle(const void *field, size_t size) {
+	/* XOR the keys of the words holding a field of the live game in
+	 * or out of the hash. */
+	size_t offset = (const unsigned char *)field - (const unsigned char *)&game;
+	for (size_t w = offset / 8; w <= (offset + size - 1) / 8; w++) {
+		game_zobrist ^= zobrist_key(w, zobrist_word(&game, w));
+	}
+}
+
+static inline void observe_toggle(const void *field, int sign) {
+	/* Take a field of the live game out of (sign -1) or back into
+	 * (sign +1) the attached observation, if there is one. */
+	if (game_observation != NULL) {
+		observe_field(field, sign);
+	}
+}
+
+#define ZSET(lv, val)                                                          \
+	do {                                                                   \
+		zobrist_toggle(&(lv), sizeof(lv));                             \
+		observe_toggle(&(lv), -1);                                     \
+		(lv) = (val);                                                  \
+		zobrist_toggle(&(lv), sizeof(lv));                             \
+		observe_toggle(&(lv), +1);                                     \
+	} while (0)
+extern const struct game_t initial_game;
+extern THREAD_LOCAL struct save_t save;
+extern THREAD_LOCAL struct settings_t settings;
 
 extern char *myreadline(const char *);
 extern bool get_command_input(command_t *);
+extern void tokenize(char *, command_t *);
+extern void get_vocab_metadata(const char *, vocab_t *, word_type_t *);
 extern void clear_command(command_t *);
 extern void speak(const char *, ...);
 extern void sspeak(int msg, ...);
@@ -333,9 +787,17 @@ extern int atdwrf(loc_t);
 extern int setbit(int);
 extern bool tstbit(int, int);
 extern void set_seed(int32_t);
-extern int32_t randrange(int32_t);
+extern int32_t randrange_at(int32_t, const char *, int);
+extern int32_t lcg_jump(int32_t, uint64_t);
+extern int32_t lcg_distance(int32_t, int32_t);
+extern int32_t rng_tell(void);
+extern void rng_seek(int32_t);
+extern void rng_skip(uint64_t);
 extern int score(enum termination);
+extern int score_object(obj_t);
+extern int score_standing(void);
 extern void terminate(enum termination) __attribute__((noreturn));
+extern void session_exit(int) __attribute__((noreturn));
 extern int savefile(FILE *);
 #if defined ADVENT_AUTOSAVE
 extern void autosave(void);
@@ -344,10 +806,68 @@ extern int suspend(void);
 extern int resume(void);
 extern int restore(FILE *);
 extern int initialise(void);
+extern int reseed(void);
 extern phase_codes_t action(command_t);
 extern void state_change(obj_t, int);
-extern bool is_valid(struct game_t);
+extern bool is_valid(struct savegame_t);
 extern void bug(enum bugtype, const char *) __attribute__((__noreturn__));
+extern void checkhints(void);
+extern bool dwarfmove(void);
+extern void describe_location(void);
+extern void playermove(int);
+extern void listobjects(void);
+extern bool do_move(void);
+extern bool do_command(void);
+extern void reset_command(void);
+extern void await_command(void);
+extern void park_command(command_t *);
+extern void resume_command(const command_t *);
+extern bool cmdlog_open(struct cmdlog_t *, FILE *);
+extern void cmdlog_write(struct cmdlog_t *, turn_t, const char *);
+extern void cmdlog_flush(struct cmdlog_t *);
+extern void cmdlog_close(struct cmdlog_t *);
+extern int cmdlog_decode(FILE *, FILE *);
+extern struct snapshot_t *snapshot_take(const struct snapshot_t *);
+extern struct snapshot_t *snapshot_fork(const struct snapshot_t *);
+extern void *snapshot_write(struct snapshot_t *, enum snapsection);
+extern void snapshot_restore(const struct snapshot_t *);
+extern void snapshot_free(struct snapshot_t *);
+extern size_t snapshot_memory(void);
+extern int64_t profile_start(void);
+extern void profile_stop(enum phase, int, int64_t);
+extern void profile_report(int);
+extern bool rngtrace_save(const struct rngtrace_t *, int);
+extern int rngtrace_decode(FILE *, FILE *);
+extern struct stats_t *stats_map(const char *, bool);
+extern size_t stats_index(enum statgroup, int);
+extern void stats_count(struct stats_t *, enum statgroup, int);
+extern FILE *transcript_open(struct transcript_t *, FILE *, FILE *);
+extern void transcript_turn(struct transcript_t *);
+extern uint64_t game_hash(void);
+extern uint64_t zobrist_full(const struct game_t *);
+extern void zobrist_rehash(void);
+extern uint64_t zobrist_hash(void);
+extern void zobrist_check(void);
+extern void observe_attach(int32_t *);
+extern void observe_full(int32_t *);
+extern void observe_rehash(void);
+extern void observe_check(void);
+extern size_t valid_actions(int *, size_t);
+extern bool valid_command(int, char *, size_t);
+extern size_t rollout_evaluate(const struct game_t *, const struct rollout_t *,
+                               struct rollout_value_t *, size_t);
+extern size_t coverage_index(enum covergroup, int);
+extern void coverage_mark(struct coverage_t *, enum covergroup, int);
+extern void coverage_turn(struct coverage_t *, const struct game_t *);
+extern bool coverage_save(const struct coverage_t *, int);
+extern int coverage_load(struct coverage_t *, FILE *);
+extern struct batch_t *batch_open(size_t, const char *const *, int);
+extern void batch_close(struct batch_t *);
+extern void batch_reset(struct batch_t *, size_t, int32_t);
+extern void batch_step(struct batch_t *, const int *);
+extern void batch_get(const struct batch_t *, size_t, struct game_t *);
+extern void batch_put(struct batch_t *, size_t, const struct game_t *);
+extern size_t batch_compare(const struct batch_t *, const struct batch_t *);
 
 /* represent an empty command word */
 static const command_word_t empty_command_word = {
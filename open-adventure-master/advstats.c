@@ -0,0 +1,98 @@
+/*
+ * 'advstats' prints the gameplay counters that advent -S sessions
+ * accumulate in a shared stats file, one per line:
+ *
+ *	group index count name
+ *
+ * It maps the file read-only and takes no locks, so it can be run as
+ * often as you like against live games.  Zero counters are left out
+ * unless -a is given.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *group_names[STATS_GROUPS] = {
+    [STATS_GAMES] = "games",
+    [STATS_VERB] = "verb",
+    [STATS_MOTION] = "motion",
+    [STATS_VISIT] = "visit",
+    [STATS_DEATH] = "death",
+    [STATS_HINT_OFFERED] = "hint-offered",
+    [STATS_HINT_USED] = "hint-used",
+};
+
+static const char *death_names[DEATH_CAUSES] = {
+    [DEATH_DWARF] = "dwarf",
+    [DEATH_TRAVEL] = "travel",
+    [DEATH_PIT] = "pit",
+    [DEATH_BRIDGE] = "bridge",
+};
+
+static const char *first_word(const string_group_t *words) {
+	return words->n > 0 ? words->strs[0] : "-";
+}
+
+static const char *name(enum statgroup group, int i) {
+	const char *desc;
+
+	switch (group) {
+	case STATS_VERB:
+		return first_word(&actions[i].words);
+	case STATS_MOTION:
+		return first_word(&motions[i].words);
+	case STATS_VISIT:
+		desc = locations[i].description.small;
+		return desc != NULL ? desc : "-";
+	case STATS_DEATH:
+		return death_names[i];
+	case STATS_HINT_OFFERED:
+	case STATS_HINT_USED:
+		return hints[i].name;
+	default:
+		return "-";
+	}
+}
+
+int main(int argc, char *argv[]) {
+	bool all = false;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "a")) != EOF) {
+		switch (ch) {
+		case 'a':
+			all = true;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-a] statsfile\n", argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "Usage: %s [-a] statsfile\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	struct stats_t *stats = stats_map(argv[optind], false);
+	if (stats == NULL) {
+		exit(EXIT_FAILURE);
+	}
+	for (int g = 0; g < STATS_GROUPS; g++) {
+		for (uint32_t i = 0; i < stats->size[g]; i++) {
+			uint64_t count = __atomic_load_n(
+			    &stats->counter[stats_index(g, i)].count,
+			    __ATOMIC_RELAXED);
+			if (count != 0 || all) {
+				printf("%s %u %" PRIu64 " %.60s\n", group_names[g],
+				       i, count, name(g, i));
+			}
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+/* end */
@@ -0,0 +1,657 @@
+/*
+ * Batched games for training agents: many games stepped in lockstep,
+ * one command each per step.
+ *
+ * A batch keeps its games in structure-of-arrays form.  Every field of
+ * struct game_t is a column holding that field for all the games, with
+ * array fields such as object places held as one run of games per
+ * element; BATCH_AT() finds a game's copy.  Observations can be read
+ * straight from the columns.
+ *
+ * The commands a game may be given are fixed when the batch is opened,
+ * and a step gives each game one of them by number.  A step goes one of
+ * two ways for each game:
+ *
+ *	vector	Plain motions: the travel table lookup, the dwarf
+ *		blocking and activation checks, the turn, clock, lamp
+ *		and hint counters, and the darkness test.  Each is a loop
+ *		over the batch touching only the columns it needs.
+ *	scalar	Anything else: the game is copied out to the live game,
+ *		played by do_command() and do_move() as main() would,
+ *		and copied back.
+ *
+ * The vector path takes a move only when it can show that the scalar
+ * path would leave exactly the same state: no random draw, no message
+ * that changes anything, no clock or lamp running out, no treasure
+ * coming into view, no hint falling due, nothing forced.  Everything
+ * it turns down goes scalar, so the vector path only ever makes a step
+ * faster, never different.  batch_compare() checks that against a
+ * batch with the vector path off.
+ *
+ * Each action must be a whole command.  Yes/no questions are answered
+ * as advent-solve does: yes to the dragon, no to hints and to
+ * reincarnation, so a death ends the game.  A batch belongs to one
+ * thread at a time, since the scalar path uses the thread's live game.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "advent.h"
+
+#define DIM(a) (sizeof(a) / sizeof(a[0]))
+#define MEMBER(f) (((struct game_t *)0)->f)
+
+#define ROUTE_NONE -1 // no travel entry for the motion: a bad direction
+#define ROUTE_SCALAR -2
+
+/* Where a column's elements lie in struct game_t */
+static const struct columnspec_t {
+	size_t offset, size, count, stride;
+} columns[BATCH_COLUMNS] = {
+#define FIELD(f) {offsetof(struct game_t, f), sizeof(MEMBER(f)), 1, 0}
+#define ARRAY(a, f)                                                            \
+	{offsetof(struct game_t, a[0].f), sizeof(MEMBER(a[0].f)),              \
+	 DIM(MEMBER(a)), sizeof(MEMBER(a[0]))}
+    [BATCH_LCG_X] = FIELD(lcg_x),
+    [BATCH_CONDS] = FIELD(conds),
+    [BATCH_DETAIL] = FIELD(detail),
+    [BATCH_IGO] = FIELD(igo),
+    [BATCH_IWEST] = FIELD(iwest),
+    [BATCH_SAVED] = FIELD(saved),
+    [BATCH_LIMIT] = FIELD(limit),
+    [BATCH_NUMDIE] = FIELD(numdie),
+    [BATCH_TRNLUZ] = FIELD(trnluz),
+    [BATCH_TURNS] = FIELD(turns),
+    [BATCH_ABBNUM] = FIELD(abbnum),
+    [BATCH_CHLOC] = FIELD(chloc),
+    [BATCH_CHLOC2] = FIELD(chloc2),
+    [BATCH_CLOCK1] = FIELD(clock1),
+    [BATCH_CLOCK2] = FIELD(clock2),
+    [BATCH_DFLAG] = FIELD(dflag),
+    [BATCH_DKILL] = FIELD(dkill),
+    [BATCH_DTOTAL] = FIELD(dtotal),
+    [BATCH_FOOBAR] = FIELD(foobar),
+    [BATCH_HOLDNG] = FIELD(holdng),
+    [BATCH_KNFLOC] = FIELD(knfloc),
+    [BATCH_LOC] = FIELD(loc),
+    [BATCH_NEWLOC] = FIELD(newloc),
+    [BATCH_OLDLOC] = FIELD(oldloc),
+    [BATCH_OLDLC2] = FIELD(oldlc2),
+    [BATCH_OLDOBJ] = FIELD(oldobj),
+    [BATCH_TALLY] = FIELD(tally),
+    [BATCH_THRESH] = FIELD(thresh),
+    [BATCH_ZZWORD] = FIELD(zzword),
+    [BATCH_BONUS] = FIELD(bonus),
+    [BATCH_CLSHNT] = FIELD(clshnt),
+    [BATCH_CLOSED] = FIELD(closed),
+    [BATCH_CLOSNG] = FIELD(closng),
+    [BATCH_LMWARN] = FIELD(lmwarn),
+    [BATCH_NOVICE] = FIELD(novice),
+    [BATCH_PANIC] = FIELD(panic),
+    [BATCH_WZDARK] = FIELD(wzdark),
+    [BATCH_BLOODED] = FIELD(blooded),
+    [BATCH_SEENBIGWORDS] = FIELD(seenbigwords),
+    [BATCH_ABBREV] = ARRAY(locs, abbrev),
+    [BATCH_ATLOC] = ARRAY(locs, atloc),
+    [BATCH_DWARF_SEEN] = ARRAY(dwarves, seen),
+    [BATCH_DWARF_LOC] = ARRAY(dwarves, loc),
+    [BATCH_DWARF_OLDLOC] = ARRAY(dwarves, oldloc),
+    [BATCH_FIXED] = ARRAY(objects, fixed),
+    [BATCH_PLACE] = ARRAY(objects, place),
+    [BATCH_PROP] = ARRAY(objects, prop),
+    [BATCH_HINT_USED] = ARRAY(hints, used),
+    [BATCH_HINT_LC] = ARRAY(hints, lc),
+    [BATCH_LINK] = {offsetof(struct game_t, link), 1, DIM(MEMBER(link)), 1},
+#undef FIELD
+#undef ARRAY
+};
+
+/* The line the scalar path is giving the live game */
+static THREAD_LOCAL const char *pending;
+
+static void *xcalloc_batch(size_t n, size_t size) {
+	void *ptr = calloc(n, size);
+
+	if (ptr == NULL) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Out of memory!\n");
+		exit(EXIT_FAILURE);
+		// LCOV_EXCL_STOP
+	}
+	return ptr;
+}
+
+static char *batch_readline(const char *prompt) {
+	/* Hand over the step's command once; then the step is done. */
+	const char *line = pending;
+
+	(void)prompt;
+	if (line == NULL) {
+		return NULL;
+	}
+	pending = NULL;
+	return strcpy(xcalloc_batch(strlen(line) + 1, 1), line);
+}
+
+static bool batch_answer(const char *question) {
+	/* Yes only to the question asked silently, the dragon's. */
+	return question == NULL;
+}
+
+static inline bool cond(loc_t loc, int bit) {
+	/* CNDBIT() without the call */
+	return (conditions[loc] >> bit) & 1;
+}
+
+static void route_table(struct batch_t *b) {
+	/* The first travel entry playermove() would try for each motion
+	 * from each location. */
+	b->route = xcalloc_batch((NLOCATIONS + 1) * NMOTIONS, sizeof(int16_t));
+	for (loc_t loc = 0; loc <= NLOCATIONS; loc++) {
+		for (int motion = 0; motion < NMOTIONS; motion++) {
+			int16_t *route = &b->route[loc * NMOTIONS + motion];
+			int kk = tkey[loc];
+			if (kk == 0) {
+				*route = ROUTE_SCALAR;
+				continue;
+			}
+			for (*route = ROUTE_NONE;; kk++) {
+				if (travel[kk].motion == HERE ||
+				    travel[kk].motion == motion) {
+					*route = kk;
+					break;
+				}
+				if (travel[kk].stop) {
+					break;
+				}
+			}
+		}
+	}
+}
+
+struct batch_t *batch_open(size_t n, const char *const *actions,
+                           int nactions) {
+	/* Make a batch of n games, all at the start of a new game with
+	 * seed 0, that take the given commands. */
+	struct batch_t *b = xcalloc_batch(1, sizeof(struct batch_t));
+	command_t command;
+
+	b->n = n;
+	b->vector = true;
+	b->nactions = nactions;
+	b->actions = xcalloc_batch(nactions, sizeof(char *));
+	b->motion = xcalloc_batch(nactions, sizeof(int16_t));
+	b->west = xcalloc_batch(nactions, sizeof(bool));
+	for (int a = 0; a < nactions; a++) {
+		char raw[LINESIZE];
+		b->actions[a] = strcpy(
+		    xcalloc_batch(strlen(actions[a]) + 1, 1), actions[a]);
+		snprintf(raw, sizeof(raw), "%s", actions[a]);
+		memset(&command, 0, sizeof(command));
+		tokenize(raw, &command);
+		vocab_t motion = command.word[0].id;
+		b->motion[a] = -1;
+		if (command.word[0].type == MOTION &&
+		    command.word[1].id == WORD_EMPTY && motion != NUL &&
+		    motion != BACK && motion != LOOK && motion != CAVE) {
+			b->motion[a] = motion;
+		}
+		b->west[a] = strncasecmp(command.word[0].raw, "west",
+		                         sizeof("west")) == 0;
+	}
+	route_table(b);
+	for (int c = 0; c < BATCH_COLUMNS; c++) {
+		b->column[c] =
+		    xcalloc_batch(n * columns[c].count, columns[c].size);
+	}
+	b->done = xcalloc_batch(n, sizeof(bool));
+	b->go = xcalloc_batch(n, sizeof(uint8_t));
+	b->dest = xcalloc_batch(n, sizeof(int16_t));
+	for (size_t i = 0; i < n; i++) {
+		batch_reset(b, i, 0);
+	}
+	return b;
+}
+
+void batch_close(struct batch_t *b) {
+	for (int a = 0; a < b->nactions; a++) {
+		free(b->actions[a]);
+	}
+	for (int c = 0; c < BATCH_COLUMNS; c++) {
+		free(b->column[c]);
+	}
+	free(b->actions);
+	free(b->motion);
+	free(b->west);
+	free(b->route);
+	free(b->done);
+	free(b->go);
+	free(b->dest);
+	free(b);
+}
+
+static void strided_copy(char *to, size_t tostep, const char *from,
+                         size_t fromstep, size_t count, size_t size) {
+	/* Copy count elements of one size between strided arrays.  The
+	 * common field sizes get fixed-size copies the compiler inlines,
+	 * since moving a game in and out is the scalar path's overhead. */
+	switch (size) {
+	case 1:
+		for (size_t k = 0; k < count; k++) {
+			to[k * tostep] = from[k * fromstep];
+		}
+		break;
+	case 2:
+		for (size_t k = 0; k < count; k++) {
+			memcpy(to + k * tostep, from + k * fromstep, 2);
+		}
+		break;
+	case 4:
+		for (size_t k = 0; k < count; k++) {
+			memcpy(to + k * tostep, from + k * fromstep, 4);
+		}
+		break;
+	default:
+		for (size_t k = 0; k < count; k++) {
+			memcpy(to + k * tostep, from + k * fromstep, size);
+		}
+	}
+}
+
+void batch_put(struct batch_t *b, size_t i, const struct game_t *g) {
+	/* Store a game as game i. */
+	for (int c = 0; c < BATCH_COLUMNS; c++) {
+		const struct columnspec_t *spec = &columns[c];
+		strided_copy((char *)b->column[c] + i * spec->size,
+		             b->n * spec->size,
+		             (const char *)g + spec->offset, spec->stride,
+		             spec->count, spec->size);
+	}
+}
+
+void batch_get(const struct batch_t *b, size_t i, struct game_t *g) {
+	/* Fetch game i.  Padding comes back zeroed. */
+	memset(g, 0, sizeof(*g));
+	for (int c = 0; c < BATCH_COLUMNS; c++) {
+		const struct columnspec_t *spec = &columns[c];
+		strided_copy((char *)g + spec->offset, spec->stride,
+		             (const char *)b->column[c] + i * spec->size,
+		             b->n * spec->size, spec->count, spec->size);
+	}
+}
+
+size_t batch_compare(const struct batch_t *a, const struct batch_t *b) {
+	/* How many games differ between two batches of the same size. */
+	size_t differ = 0;
+
+	for (size_t i = 0; i < a->n; i++) {
+		bool same = a->done[i] == b->done[i];
+		for (int c = 0; c < BATCH_COLUMNS && same; c++) {
+			const struct columnspec_t *spec = &columns[c];
+			for (size_t k = 0; k < spec->count && same; k++) {
+				size_t at = (k * a->n + i) * spec->size;
+				same = memcmp((const char *)a->column[c] + at,
+				              (const char *)b->column[c] + at,
+				              spec->size) == 0;
+			}
+		}
+		differ += !same;
+	}
+	return differ;
+}
+
+static void play(struct batch_t *b, size_t i, const char *line,
+                 int32_t seed) {
+	/* Run game i through the engine on the live game: from the
+	 * prompt with a command, or (line NULL) from a new game to its
+	 * first prompt. */
+	struct settings_t caller = settings;
+	jmp_buf over;
+
+	memset(&settings, 0, sizeof(settings));
+	settings.silent = true;
+	settings.answer = batch_answer;
+	settings.readline = batch_readline;
+	settings.exitjmp = &over;
+	pending = line;
+	if (setjmp(over) == 0) {
+		if (line == NULL) {
+			reset_command();
+			initialise();
+			set_seed(seed);
+			ZSET(game.novice, false);
+		} else {
+			batch_get(b, i, &game);
+			zobrist_rehash();
+			await_command();
+		}
+		/* The main() loop, entered at the prompt when resuming */
+		for (bool moving = line == NULL;; moving = true) {
+			if (moving && !do_move()) {
+				continue;
+			}
+			if (!do_command()) {
+				break;
+			}
+		}
+		b->done[i] = false;
+	} else {
+		b->done[i] = true;
+	}
+	settings = caller;
+	batch_put(b, i, &game);
+}
+
+void batch_reset(struct batch_t *b, size_t i, int32_t seed) {
+	/* Start game i afresh, as advent does but skipping the
+	 * instructions, with the given seed. */
+	play(b, i, NULL, seed);
+}
+
+static bool dark(const struct batch_t *b, size_t i, loc_t loc) {
+	/* IS_DARK_HERE() for game i standing at loc */
+	int16_t place = BATCH_AT(b, BATCH_PLACE, int16_t, LAMP, i);
+
+	return !cond(loc, COND_LIT) &&
+	       (BATCH_AT(b, BATCH_PROP, int8_t, LAMP, i) == LAMP_DARK ||
+	        !(place == loc || place == CARRIED ||
+	          BATCH_AT(b, BATCH_FIXED, int16_t, LAMP, i) == loc));
+}
+
+static bool stashed(const struct batch_t *b, size_t i, int k) {
+	/* As listobjects() tests object-list entry k: only a first
+	 * placement has a prop of its own. */
+	return k <= NOBJECTS &&
+	       BATCH_AT(b, BATCH_PROP, int8_t, k, i) < STATE_NOTFOUND;
+}
+
+static bool traveleq(int a, int b) {
+	/* As in turn.c */
+	return (travel[a].condtype == travel[b].condtype) &&
+	       (travel[a].condarg1 == travel[b].condarg1) &&
+	       (travel[a].condarg2 == travel[b].condarg2) &&
+	       (travel[a].desttype == travel[b].desttype) &&
+	       (travel[a].destval == travel[b].destval);
+}
+
+static loc_t travel_to(const struct batch_t *b, size_t i, loc_t loc,
+                       int motion) {
+	/* Where playermove() would send game i, or LOC_NOWHERE if that
+	 * takes a random draw or special handling. */
+	int te = b->route[loc * NMOTIONS + motion];
+
+	if (te == ROUTE_NONE) {
+		return loc;
+	}
+	if (te == ROUTE_SCALAR) {
+		return LOC_NOWHERE;
+	}
+	for (;;) {
+		long type = travel[te].condtype, arg1 = travel[te].condarg1;
+		bool pass;
+		if (type == cond_goto || type == cond_pct) {
+			if (arg1 != 0) {
+				return LOC_NOWHERE;
+			}
+			pass = true;
+		} else if (type < cond_not) {
+			int16_t place = BATCH_AT(b, BATCH_PLACE, int16_t, arg1, i);
+			pass = place == CARRIED ||
+			       (type == cond_with &&
+			        (place == loc ||
+			         BATCH_AT(b, BATCH_FIXED, int16_t, arg1, i) ==
+			             loc));
+		} else {
+			pass = BATCH_AT(b, BATCH_PROP, int8_t, arg1, i) !=
+			       travel[te].condarg2;
+		}
+		if (pass) {
+			break;
+		}
+		int next = te;
+		do {
+			if (travel[next].stop) {
+				return LOC_NOWHERE; // LCOV_EXCL_LINE
+			}
+			++next;
+		} while (traveleq(te, next));
+		te = next;
+	}
+	switch (travel[te].desttype) {
+	case dest_goto:
+		return travel[te].destval;
+	case dest_speak:
+		return loc;
+	default:
+		return LOC_NOWHERE;
+	}
+}
+
+static void vector_select(struct batch_t *b, const int *action) {
+	/* Decide which games the vector path can take, and where they
+	 * go.  Nothing is changed yet. */
+	size_t n = b->n;
+	uint8_t *go = b->go;
+	int16_t *dest = b->dest;
+	const int16_t *loc = b->column[BATCH_LOC];
+	const int32_t *turns = b->column[BATCH_TURNS];
+
+	/* Plain motions only, and not once the cave is closing */
+	const bool *closng = b->column[BATCH_CLOSNG];
+	for (size_t i = 0; i < n; i++) {
+		go[i] = !b->done[i] && b->motion[action[i]] >= 0 && !closng[i];
+	}
+
+	/* closecheck(): no turn threshold crossed, no clock run out */
+	for (int t = 0; t < NTHRESHOLDS; t++) {
+		for (size_t i = 0; i < n; i++) {
+			go[i] &= turns[i] != turn_thresholds[t].threshold;
+		}
+	}
+	const int16_t *tally = b->column[BATCH_TALLY];
+	const int16_t *clock1 = b->column[BATCH_CLOCK1];
+	const int16_t *clock2 = b->column[BATCH_CLOCK2];
+	for (size_t i = 0; i < n; i++) {
+		int tick = tally[i] == 0 && cond(loc[i], COND_DEEP) &&
+		           loc[i] != LOC_Y2;
+		int c1 = clock1[i] - tick;
+		go[i] &= c1 != 0 && clock2[i] - (c1 < 0) != 0;
+	}
+
+	/* lampcheck(): not within warning time of the lamp going out */
+	const int32_t *limit = b->column[BATCH_LIMIT];
+	const int8_t *lamp = &BATCH_AT(b, BATCH_PROP, int8_t, LAMP, 0);
+	for (size_t i = 0; i < n; i++) {
+		go[i] &= limit[i] - (lamp[i] == LAMP_BRIGHT) > WARNTIME;
+	}
+
+	/* No "west" nag due */
+	const int32_t *iwest = b->column[BATCH_IWEST];
+	for (size_t i = 0; i < n; i++) {
+		go[i] &= !b->west[action[i]] || iwest[i] != 9;
+	}
+
+	/* playermove(): the travel table */
+	for (size_t i = 0; i < n; i++) {
+		if (go[i]) {
+			dest[i] = travel_to(b, i, loc[i], b->motion[action[i]]);
+			go[i] = dest[i] != LOC_NOWHERE;
+		}
+	}
+
+	/* do_move(): a dwarf who has seen him may block the way */
+	for (int d = 1; d <= NDWARVES - 1; d++) {
+		const bool *seen = &BATCH_AT(b, BATCH_DWARF_SEEN, bool, d, 0);
+		const int16_t *from =
+		    &BATCH_AT(b, BATCH_DWARF_OLDLOC, int16_t, d, 0);
+		for (size_t i = 0; i < n; i++) {
+			if (go[i] && seen[i] && from[i] == dest[i] &&
+			    dest[i] != loc[i] && !cond(loc[i], COND_FORCED) &&
+			    !cond(loc[i], COND_NOARRR)) {
+				dest[i] = loc[i];
+			}
+		}
+	}
+
+	/* dwarfmove() doing nothing but maybe waking up the dwarves, no
+	 * pit to fall into, no forced motion, no draw at Y2 */
+	const int16_t *dflag = b->column[BATCH_DFLAG];
+	const bool *wzdark = b->column[BATCH_WZDARK];
+	for (size_t i = 0; i < n; i++) {
+		loc_t to = dest[i];
+		go[i] &= to != LOC_Y2 && !cond(to, COND_FORCED) &&
+		         (cond(to, COND_NOARRR) || dflag[i] == 0 ||
+		          (dflag[i] == 1 && !cond(to, COND_DEEP)));
+		if (go[i] && wzdark[i] && dark(b, i, to)) {
+			go[i] = false;
+		}
+	}
+
+	/* listobjects(): nothing comes into view for the first time */
+	const int16_t *nugget = &BATCH_AT(b, BATCH_PLACE, int16_t, NUGGET, 0);
+	for (size_t i = 0; i < n; i++) {
+		if (!go[i] || dark(b, i, dest[i])) {
+			continue;
+		}
+		for (int k = BATCH_AT(b, BATCH_ATLOC, uint8_t, dest[i], i);
+		     k != 0; k = BATCH_AT(b, BATCH_LINK, uint8_t, k, i)) {
+			obj_t obj = k > NOBJECTS ? k - NOBJECTS : k;
+			if (obj == STEPS && nugget[i] == CARRIED) {
+				continue;
+			}
+			if (stashed(b, i, k) ||
+			    BATCH_AT(b, BATCH_PROP, int8_t, obj, i) ==
+			        STATE_NOTFOUND) {
+				go[i] = false;
+				break;
+			}
+		}
+	}
+
+	/* checkhints(): no hint falls due */
+	const int32_t *conds = b->column[BATCH_CONDS];
+	for (int h = 0; h < NHINTS; h++) {
+		const bool *used = &BATCH_AT(b, BATCH_HINT_USED, bool, h, 0);
+		const int32_t *lc = &BATCH_AT(b, BATCH_HINT_LC, int32_t, h, 0);
+		for (size_t i = 0; i < n; i++) {
+			loc_t to = dest[i];
+			if (go[i] && !used[i] && conditions[to] >= conds[i] &&
+			    (cond(to, h + 1 + COND_HBASE) ? lc[i] + 1 : 0) >=
+			        hints[h].turns) {
+				go[i] = false;
+			}
+		}
+	}
+}
+
+static void vector_apply(struct batch_t *b, const int *action) {
+	/* Make the moves vector_select() passed, field by field, in the
+	 * order the engine makes them. */
+	size_t n = b->n;
+	const uint8_t *go = b->go;
+	const int16_t *dest = b->dest;
+	int16_t *loc = b->column[BATCH_LOC];
+
+	int16_t *foobar = b->column[BATCH_FOOBAR];
+	int32_t *turns = b->column[BATCH_TURNS];
+	for (size_t i = 0; i < n; i++) {
+		if (go[i]) {
+			foobar[i] = foobar[i] > WORD_EMPTY ? -foobar[i] : WORD_EMPTY;
+			turns[i]++;
+		}
+	}
+
+	/* Clocks tick by where he was */
+	const int16_t *tally = b->column[BATCH_TALLY];
+	int16_t *clock1 = b->column[BATCH_CLOCK1];
+	int16_t *clock2 = b->column[BATCH_CLOCK2];
+	int32_t *limit = b->column[BATCH_LIMIT];
+	const int8_t *lamp = &BATCH_AT(b, BATCH_PROP, int8_t, LAMP, 0);
+	int32_t *iwest = b->column[BATCH_IWEST];
+	for (size_t i = 0; i < n; i++) {
+		if (go[i]) {
+			if (tally[i] == 0 && cond(loc[i], COND_DEEP) &&
+			    loc[i] != LOC_Y2) {
+				clock1[i]--;
+			}
+			if (clock1[i] < 0) {
+				clock2[i]--;
+			}
+			limit[i] -= lamp[i] == LAMP_BRIGHT;
+			iwest[i] += b->west[action[i]];
+		}
+	}
+
+	int16_t *newloc = b->column[BATCH_NEWLOC];
+	int16_t *oldloc = b->column[BATCH_OLDLOC];
+	int16_t *oldlc2 = b->column[BATCH_OLDLC2];
+	int16_t *dflag = b->column[BATCH_DFLAG];
+	int16_t *oldobj = b->column[BATCH_OLDOBJ];
+	for (size_t i = 0; i < n; i++) {
+		if (go[i]) {
+			oldobj[i] = NO_OBJECT; // see clear_command()
+			oldlc2[i] = oldloc[i];
+			oldloc[i] = loc[i];
+			loc[i] = newloc[i] = dest[i];
+			if (dflag[i] == 0 && cond(dest[i], COND_DEEP) &&
+			    !cond(dest[i], COND_NOARRR)) {
+				dflag[i] = 1;
+			}
+		}
+	}
+
+	/* What he sees there */
+	bool *wzdark = b->column[BATCH_WZDARK];
+	int16_t *knfloc = b->column[BATCH_KNFLOC];
+	for (size_t i = 0; i < n; i++) {
+		if (go[i]) {
+			wzdark[i] = dark(b, i, loc[i]);
+			if (!wzdark[i]) {
+				BATCH_AT(b, BATCH_ABBREV, uint16_t, loc[i], i)++;
+			}
+			if (knfloc[i] > LOC_NOWHERE && knfloc[i] != loc[i]) {
+				knfloc[i] = LOC_NOWHERE;
+			}
+		}
+	}
+
+	const int32_t *conds = b->column[BATCH_CONDS];
+	for (int h = 0; h < NHINTS; h++) {
+		const bool *used = &BATCH_AT(b, BATCH_HINT_USED, bool, h, 0);
+		int32_t *lc = &BATCH_AT(b, BATCH_HINT_LC, int32_t, h, 0);
+		for (size_t i = 0; i < n; i++) {
+			if (go[i] && !used[i] && conditions[loc[i]] >= conds[i]) {
+				lc[i] = cond(loc[i], h + 1 + COND_HBASE) ? lc[i] + 1
+				                                         : 0;
+			}
+		}
+	}
+}
+
+void batch_step(struct batch_t *b, const int *action) {
+	/* Give game i command action[i], for every game not over. */
+	if (b->vector) {
+		vector_select(b, action);
+		vector_apply(b, action);
+	} else {
+		memset(b->go, 0, b->n);
+	}
+	for (size_t i = 0; i < b->n; i++) {
+		if (b->done[i]) {
+			continue;
+		}
+		b->steps++;
+		if (!b->go[i]) {
+			b->scalar++;
+			play(b, i, b->actions[action[i]], 0);
+		}
+	}
+}
+
+/* end */
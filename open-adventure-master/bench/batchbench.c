@@ -0,0 +1,191 @@
+/*
+ * batchbench - step batches of games in lockstep through batch.c and
+ * report env-steps per second per core, as a training loop would see
+ * them, and how many steps the vector path took.
+ *
+ * Each thread owns one batch and plays random commands in every game,
+ * weighted toward movement, starting a fresh game (with a new seed)
+ * wherever one ends.  The run is done once with the vector path and
+ * once with every step scalar, for comparison.
+ *
+ * With -c, each thread steps a twin batch with the vector path off
+ * through the same commands and compares the two after every step;
+ * any difference is a bug in the vector path.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *commands[] = {
+    /* Movement, listed several times to weight it */
+    "n", "s", "e", "w", "ne", "nw", "se", "sw", "u", "d", "in", "out",
+    "n", "s", "e", "w", "ne", "nw", "se", "sw", "u", "d", "in", "out",
+    "n", "s", "e", "w", "u", "d", "west", "xyzzy", "plugh", "enter",
+    "upstream", "downstream", "forest", "valley", "building", "back",
+    "look",
+    /* Things to do along the way */
+    "get lamp", "light lamp", "get keys", "unlock grate", "open grate",
+    "get cage", "get bird", "get rod", "drop rod", "inven", "drop all",
+    "get all", "throw axe", "kill dwarf", "score", "wave rod"};
+#define NCOMMANDS (int)(sizeof(commands) / sizeof(commands[0]))
+
+struct worker_t {
+	pthread_t thread;
+	bool vector;
+	bool check;
+	size_t games;
+	long steps;
+	uint32_t rng;
+	double busy;       // seconds spent stepping
+	uint64_t done;     // env-steps
+	uint64_t scalar;   // of them on the scalar path
+	uint64_t differ;   // mismatches seen in check mode
+};
+
+char *myreadline(const char *prompt) {
+	/* Batches bring their own input; see batch.c. */
+	(void)prompt;
+	return NULL;
+}
+
+static uint32_t xorshift(uint32_t *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *worker(void *arg) {
+	struct worker_t *w = arg;
+	struct batch_t *b = batch_open(w->games, commands, NCOMMANDS);
+	struct batch_t *twin = NULL;
+	int *action = malloc(w->games * sizeof(int));
+
+	b->vector = w->vector;
+	if (w->check) {
+		twin = batch_open(w->games, commands, NCOMMANDS);
+		twin->vector = false;
+	}
+	for (long s = 0; s < w->steps; s++) {
+		for (size_t i = 0; i < w->games; i++) {
+			action[i] = xorshift(&w->rng) % NCOMMANDS;
+		}
+		double t0 = now();
+		batch_step(b, action);
+		w->busy += now() - t0;
+		if (twin != NULL) {
+			batch_step(twin, action);
+			w->differ += batch_compare(b, twin);
+		}
+		for (size_t i = 0; i < w->games; i++) {
+			if (b->done[i] || (twin != NULL && twin->done[i])) {
+				int32_t seed = xorshift(&w->rng) % LCG_M;
+				batch_reset(b, i, seed);
+				if (twin != NULL) {
+					batch_reset(twin, i, seed);
+				}
+			}
+		}
+	}
+	w->done = b->steps;
+	w->scalar = b->scalar;
+	if (twin != NULL) {
+		batch_close(twin);
+	}
+	batch_close(b);
+	free(action);
+	return NULL;
+}
+
+static uint64_t run(const char *name, bool vector, bool check, long jobs,
+                    size_t games, long steps) {
+	/* One pass; returns mismatches found. */
+	struct worker_t *w = calloc(jobs, sizeof(struct worker_t));
+	uint64_t done = 0, scalar = 0, differ = 0;
+	double busy = 0;
+
+	for (long i = 0; i < jobs; i++) {
+		w[i].vector = vector;
+		w[i].check = check;
+		w[i].games = games;
+		w[i].steps = steps;
+		w[i].rng = 2463534242u + i * 7919;
+		pthread_create(&w[i].thread, NULL, worker, &w[i]);
+	}
+	for (long i = 0; i < jobs; i++) {
+		pthread_join(w[i].thread, NULL);
+		done += w[i].done;
+		scalar += w[i].scalar;
+		differ += w[i].differ;
+		busy += w[i].busy;
+	}
+	printf("%-8s %7ld %7zu %12" PRIu64 " %16.0f %8.1f%%\n", name, jobs,
+	       games, done, done / busy,
+	       done ? 100.0 * (done - scalar) / done : 0.0);
+	free(w);
+	return differ;
+}
+
+int main(int argc, char *argv[]) {
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t games = 1024;
+	long steps = 1000;
+	bool check = false;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "cj:n:s:")) != EOF) {
+		switch (ch) {
+		case 'c':
+			check = true;
+			break;
+		case 'j':
+			jobs = atol(optarg);
+			break;
+		case 'n':
+			games = atol(optarg);
+			break;
+		case 's':
+			steps = atol(optarg);
+			break;
+		default:
+			fprintf(stderr,
+			        "Usage: %s [-c] [-j threads] [-n games] "
+			        "[-s steps]\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+	if (games < 1) {
+		games = 1;
+	}
+
+	if (check) {
+		uint64_t differ = run("check", true, true, jobs, games, steps);
+		printf("%" PRIu64 " mismatches\n", differ);
+		return differ == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	printf("%-8s %7s %7s %12s %16s %9s\n", "path", "threads", "games",
+	       "env-steps", "env-steps/s/core", "vector");
+	run("vector", true, false, jobs, games, steps);
+	run("scalar", false, false, jobs, games, steps);
+	return EXIT_SUCCESS;
+}
+
+/* end */
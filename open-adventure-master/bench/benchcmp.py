@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+# SPDX-License-Identifier: BSD-2-Clause
+"""
+Compare two JSON reports from bench/microbench and flag regressions.
+
+usage: benchcmp.py [-t percent] baseline.json current.json
+
+Prints the median of every benchmark in both reports and the change.
+Exits 1 if any benchmark's median got slower by more than the
+threshold (default 10 percent), so CI can gate on it.
+"""
+
+# pylint: disable=consider-using-f-string,invalid-name
+
+import getopt
+import json
+import sys
+
+
+def load(path):
+    with open(path, encoding="ascii") as fp:
+        report = json.load(fp)
+    return {b["name"]: b["median"] for b in report["benchmarks"]}
+
+
+def main():
+    threshold = 10.0
+    (options, arguments) = getopt.getopt(sys.argv[1:], "t:")
+    for (switch, val) in options:
+        if switch == "-t":
+            threshold = float(val)
+    if len(arguments) != 2:
+        sys.stderr.write(__doc__)
+        sys.exit(2)
+    baseline, current = load(arguments[0]), load(arguments[1])
+
+    regressions = 0
+    for name in baseline:
+        if name not in current:
+            print("%-30s %10.1f %10s" % (name, baseline[name], "missing"))
+            continue
+        old, new = baseline[name], current[name]
+        change = (new - old) * 100.0 / old if old else 0.0
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-30s %10.1f %10.1f %+7.1f%%%s" % (name, old, new, change, flag))
+    for name in current:
+        if name not in baseline:
+            print("%-30s %10s %10.1f" % (name, "new", current[name]))
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,146 @@
+/*
+ * forkbench - compare copy-on-write snapshots against whole-struct
+ * copies for the fork-heavy workload of search and what-if tooling.
+ *
+ * Each fork restores a parent state, applies a turn-sized mutation
+ * (player moves every time, dwarves half the time, an object changes
+ * hands one time in ten) and captures the child.  A ring of live
+ * snapshots is kept so memory per snapshot reflects real sharing.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint32_t xorshift_state = 2463534242u;
+
+static uint32_t xorshift(void) {
+	xorshift_state ^= xorshift_state << 13;
+	xorshift_state ^= xorshift_state >> 17;
+	xorshift_state ^= xorshift_state << 5;
+	return xorshift_state;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void mutate(void) {
+	/* Roughly what one turn does to the state */
+	++game.turns;
+	game.oldloc = game.loc;
+	game.loc = 1 + xorshift() % NLOCATIONS;
+	if (xorshift() % 2 == 0) {
+		int i = 1 + xorshift() % NDWARVES;
+		game.dwarves[i].oldloc = game.dwarves[i].loc;
+		game.dwarves[i].loc = game.loc;
+	}
+	if (xorshift() % 10 == 0) {
+		obj_t obj = 1 + xorshift() % NOBJECTS;
+		if (game.objects[obj].fixed == IS_FREE &&
+		    game.objects[obj].place != LOC_NOWHERE) {
+			move(obj, TOTING(obj) ? game.loc : CARRIED);
+		}
+	}
+}
+
+static void report(const char *name, long forks, double secs, size_t bytes,
+                   long live) {
+	printf("%-10s %10.0f forks/sec %8zu bytes/snapshot\n", name,
+	       forks / secs, bytes / live);
+}
+
+int main(int argc, char *argv[]) {
+	long forks = 2000000, live = 100000;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "n:l:")) != EOF) {
+		switch (ch) {
+		case 'n':
+			forks = atol(optarg);
+			break;
+		case 'l':
+			live = atol(optarg);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n forks] [-l live]\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (forks < live || live < 1) {
+		fprintf(stderr, "forkbench: need forks >= live >= 1\n");
+		exit(EXIT_FAILURE);
+	}
+
+	initialise();
+	struct game_t start = game;
+
+	/* Whole-struct copies */
+	struct game_t **copies = calloc(live, sizeof(struct game_t *));
+	copies[0] = malloc(sizeof(struct game_t));
+	*copies[0] = start;
+	double t0 = now();
+	for (long i = 1; i < forks; i++) {
+		long parent = xorshift() % (i < live ? i : live);
+		long slot = i % live;
+		game = *copies[parent];
+		mutate();
+		if (copies[slot] == NULL) {
+			copies[slot] = malloc(sizeof(struct game_t));
+		}
+		memcpy(copies[slot], &game, sizeof(struct game_t));
+	}
+	report("memcpy", forks, now() - t0, live * sizeof(struct game_t), live);
+
+	/* Copy-on-write snapshots */
+	xorshift_state = 2463534242u;
+	game = start;
+	struct snapshot_t **snaps = calloc(live, sizeof(struct snapshot_t *));
+	snaps[0] = snapshot_take(NULL);
+	t0 = now();
+	for (long i = 1; i < forks; i++) {
+		long parent = xorshift() % (i < live ? i : live);
+		long slot = i % live;
+		snapshot_restore(snaps[parent]);
+		mutate();
+		struct snapshot_t *child = snapshot_take(snaps[parent]);
+		snapshot_free(snaps[slot]);
+		snaps[slot] = child;
+	}
+	report("cow", forks, now() - t0, snapshot_memory(), live);
+
+	/* Pure forks with no capture, the cheapest case */
+	t0 = now();
+	for (long i = 0; i < forks; i++) {
+		struct snapshot_t *child = snapshot_fork(snaps[i % live]);
+		snapshot_free(child);
+	}
+	report("cow-fork", forks, now() - t0, snapshot_memory(), live);
+
+	for (long i = 0; i < live; i++) {
+		free(copies[i]);
+		snapshot_free(snaps[i]);
+	}
+	free(copies);
+	free(snaps);
+	return EXIT_SUCCESS;
+}
+
+/*
+ * Unused, but required for linkage.
+ * See the actually useful version of this in main.c
+ */
+char *myreadline(const char *prompt) {
+	(void)prompt;
+	return NULL;
+}
+
+/* end */
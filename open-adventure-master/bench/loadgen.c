@@ -0,0 +1,315 @@
+/*
+ * loadgen - drive the engine through long games and report sustained
+ * throughput: turns per second per core, per-turn latency percentiles
+ * and heap allocations per turn.
+ *
+ * One thread per core each plays games back to back until it has done
+ * its share of turns.  A turn is one do_move()/do_command() round, the
+ * same unit advent's main loop runs, and the one that ends a game
+ * (death, quit, script exhausted) counts too; the thread then starts
+ * another from the same scenario.
+ *
+ * Scenarios put the player somewhere interesting with a lit lamp and
+ * then feed random commands, weighted toward movement:
+ *	surface	the normal start of game
+ *	maze	the all-alike maze, dwarves active
+ *	deep	the Hall of Mists with dwarves throwing knives
+ *	closing	deep cave with every treasure found, so the cave closes
+ *		and the endgame repository opens a few turns in
+ * or, with -s, replay a command log (as written by advent -l) again
+ * and again.
+ *
+ * Allocations are counted by wrapping malloc and friends at link time
+ * (see the Makefile), so they cover the engine's own calls only.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Heap calls made by this thread; see the --wrap flags in the Makefile */
+static THREAD_LOCAL long allocations;
+
+void *__real_malloc(size_t);
+void *__real_calloc(size_t, size_t);
+void *__real_realloc(void *, size_t);
+void *__wrap_malloc(size_t);
+void *__wrap_calloc(size_t, size_t);
+void *__wrap_realloc(void *, size_t);
+
+void *__wrap_malloc(size_t size) {
+	allocations++;
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+	allocations++;
+	return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+	allocations++;
+	return __real_realloc(ptr, size);
+}
+
+static const char *commands[] = {
+    /* Movement, listed several times to weight it */
+    "n", "s", "e", "w", "ne", "nw", "se", "sw", "u", "d", "in", "out",
+    "n", "s", "e", "w", "u", "d", "back", "look",
+    /* Things to do along the way */
+    "get lamp", "drop lamp", "get axe", "throw axe", "kill dwarf", "inven",
+    "get all", "drop all", "score", "xyzzy", "plugh", "y", "n", "no",
+    "light lamp", "get coins", "open grate", "feed bird", "wave rod"};
+#define NCOMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+struct scenario_t {
+	const char *name;
+	loc_t loc;
+	int dflag;
+	bool closing;
+};
+
+static const struct scenario_t scenarios[] = {
+    {"surface", LOC_START, 0, false},
+    {"maze", LOC_ALIKE1, 2, false},
+    {"deep", LOC_MISTHALL, 3, false},
+    {"closing", LOC_MISTHALL, 2, true},
+};
+
+struct worker_t {
+	pthread_t thread;
+	const struct scenario_t *scenario;
+	uint32_t rng;
+	long quota;      // turns to play
+	long done;       // turns played
+	uint32_t *ns;    // per-turn latency
+	long allocs;     // heap calls across all turns
+	double busy;     // seconds spent in turns
+	bool inturn;     // a turn is under way, begun at started
+	double started;
+	long before;     // allocations when it began
+};
+
+/* Script replay: -s file, split into lines */
+static char **script;
+static int nscript;
+
+static THREAD_LOCAL struct worker_t *self;
+static THREAD_LOCAL int scriptline;
+
+static uint32_t xorshift(uint32_t *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *copy_line(const char *line) {
+	/* Like readline(), hand back a fresh heap copy; the allocation is
+	 * input's, not the engine's, so it goes uncounted. */
+	size_t len = strlen(line) + 1;
+	return memcpy(__real_malloc(len), line, len);
+}
+
+char *myreadline(const char *prompt) {
+	/* Next scripted line, or a random command. */
+	(void)prompt;
+	if (script != NULL) {
+		if (scriptline >= nscript) {
+			return NULL;
+		}
+		return copy_line(script[scriptline++]);
+	}
+	return copy_line(commands[xorshift(&self->rng) % NCOMMANDS]);
+}
+
+static void setup(const struct scenario_t *sc) {
+	/* Put the player in the scenario with a lamp that will not die. */
+	if (sc == NULL) {
+		return;
+	}
+	game.novice = false;
+	game.loc = game.newloc = game.oldloc = game.oldlc2 = sc->loc;
+	game.dflag = sc->dflag;
+	game.limit = 100000;
+	carry(LAMP, game.objects[LAMP].place);
+	game.objects[LAMP].prop = LAMP_BRIGHT;
+	if (sc->closing) {
+		for (obj_t obj = 1; obj <= NOBJECTS; obj++) {
+			if (objects[obj].is_treasure) {
+				OBJECT_SET_FOUND(obj);
+			}
+		}
+		game.tally = 0;
+		game.clock1 = 3;
+	}
+	zobrist_rehash(); // the scenario was poked in behind ZSET()'s back
+}
+
+static void end_turn(struct worker_t *w) {
+	/* Count the turn under way, if any, however it ended. */
+	if (!w->inturn) {
+		return;
+	}
+	double t = now() - w->started;
+	w->inturn = false;
+	w->busy += t;
+	w->ns[w->done++] = t * 1e9 < UINT32_MAX ? t * 1e9 : UINT32_MAX;
+	w->allocs += allocations - w->before;
+}
+
+static void play(struct worker_t *w) {
+	/* One game, until it ends or the quota is met. */
+	jmp_buf over;
+
+	memset(&settings, 0, sizeof(settings));
+	settings.outfp = fopen("/dev/null", "w");
+	settings.prompt = true;
+	settings.exitjmp = &over;
+	reset_command();
+	scriptline = 0;
+
+	if (setjmp(over) == 0) {
+		initialise();
+		set_seed(xorshift(&w->rng));
+		if (script == NULL) {
+			setup(w->scenario);
+		}
+		while (w->done < w->quota) {
+			w->before = allocations;
+			w->started = now();
+			w->inturn = true;
+			if (do_move() && !do_command()) {
+				terminate(quitgame);
+			}
+			end_turn(w);
+		}
+	} else {
+		end_turn(w); // the game ended, jumping out of its last turn
+	}
+	fclose(settings.outfp);
+}
+
+static void *worker(void *arg) {
+	self = arg;
+	while (self->done < self->quota) {
+		play(self);
+	}
+	return NULL;
+}
+
+static int compare(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void run(const struct scenario_t *sc, const char *name, long jobs,
+                long turns) {
+	struct worker_t *w = calloc(jobs, sizeof(struct worker_t));
+	long total = 0, allocs = 0;
+	double busy = 0;
+
+	for (long i = 0; i < jobs; i++) {
+		w[i].scenario = sc;
+		w[i].rng = 2463534242u + i * 7919;
+		w[i].quota = turns / jobs + (i < turns % jobs);
+		w[i].ns = malloc(w[i].quota * sizeof(uint32_t));
+		pthread_create(&w[i].thread, NULL, worker, &w[i]);
+	}
+	uint32_t *all = malloc(turns * sizeof(uint32_t));
+	for (long i = 0; i < jobs; i++) {
+		pthread_join(w[i].thread, NULL);
+		memcpy(all + total, w[i].ns, w[i].done * sizeof(uint32_t));
+		total += w[i].done;
+		allocs += w[i].allocs;
+		busy += w[i].busy;
+		free(w[i].ns);
+	}
+	qsort(all, total, sizeof(uint32_t), compare);
+	printf("%-10s %7ld %10ld %12.0f %8u %8u %9.2f\n", name, jobs, total,
+	       total / busy, all[total / 2], all[total * 99 / 100],
+	       (double)allocs / total);
+	free(all);
+	free(w);
+}
+
+static void load_script(const char *name) {
+	FILE *fp = fopen(name, "r");
+	char line[LINESIZE];
+
+	if (fp == NULL) {
+		perror(name);
+		exit(EXIT_FAILURE);
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		line[strcspn(line, "\n")] = '\0';
+		script = realloc(script, (nscript + 1) * sizeof(char *));
+		script[nscript++] = strdup(line);
+	}
+	fclose(fp);
+}
+
+int main(int argc, char *argv[]) {
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	long turns = 1000000;
+	const char *only = NULL, *scriptname = NULL;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "j:n:c:s:")) != EOF) {
+		switch (ch) {
+		case 'j':
+			jobs = atol(optarg);
+			break;
+		case 'n':
+			turns = atol(optarg);
+			break;
+		case 'c':
+			only = optarg;
+			break;
+		case 's':
+			scriptname = optarg;
+			break;
+		default:
+			fprintf(stderr,
+			        "Usage: %s [-j threads] [-n turns] "
+			        "[-c scenario | -s logfile]\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+	if (turns < jobs) {
+		turns = jobs;
+	}
+
+	printf("%-10s %7s %10s %12s %8s %8s %9s\n", "scenario", "threads",
+	       "turns", "turns/s/core", "p50 ns", "p99 ns", "allocs/turn");
+	if (scriptname != NULL) {
+		load_script(scriptname);
+		run(NULL, "script", jobs, turns);
+		return EXIT_SUCCESS;
+	}
+	for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		if (only == NULL || strcmp(only, scenarios[i].name) == 0) {
+			run(&scenarios[i], scenarios[i].name, jobs, turns);
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+/* end */
@@ -0,0 +1,392 @@
+/*
+ * microbench - time the engine's hot paths one call at a time and
+ * report the results as JSON, for tracking against a stored baseline
+ * with bench/benchcmp.py.
+ *
+ * Each case gets its own starting state.  Stateful cases restore it
+ * before every call, so they include one struct copy; the "reset" case
+ * measures that copy on its own.  Cases that draw random numbers start
+ * each call from a different LCG value, so their timings average over
+ * the branches the dice pick rather than replaying one path.
+ *
+ * Output goes to /dev/null through the normal stdio path, so the speak
+ * cases include formatting and buffering but not a terminal.
+ *
+ * With -c, nothing is timed: lcg_jump() and lcg_distance() are checked
+ * against stepping the LCG one draw at a time, through more than a
+ * whole period, and the mismatches are counted.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RUNS 5 // timed runs per case; the median is reported
+
+static struct game_t base;  // state each stateful call starts from
+static long iteration;      // calls so far in the current run
+static const char **inputs; // lines myreadline() hands out in turn
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void reset(void) {
+	game = base;
+	iteration++;
+}
+
+static void reroll(void) {
+	/* Restore, then vary the dice so every call takes its own path */
+	reset();
+	game.lcg_x = (iteration * 40503) % LCG_M;
+}
+
+/* Setups */
+
+static void at_start(void) { base.loc = base.newloc = LOC_START; }
+
+static void in_building(void) {
+	base.loc = base.newloc = LOC_BUILDING;
+	base.oldloc = base.oldlc2 = LOC_START;
+}
+
+static void in_maze(void) {
+	base.loc = base.newloc = LOC_MAZEEND1;
+	base.oldloc = base.oldlc2 = LOC_MAZEEND1;
+}
+
+static void deep(int dflag) {
+	/* In the Hall of Mists with the dwarves at the given stage */
+	base.loc = base.newloc = base.oldloc = base.oldlc2 = LOC_MISTHALL;
+	base.dflag = dflag;
+	if (dflag >= 2) {
+		/* Bring the pack close enough to matter */
+		for (int i = 1; i < PIRATE; i++) {
+			base.dwarves[i].loc = LOC_MISTHALL + i;
+		}
+	}
+}
+
+static void dflag0(void) { deep(0); }
+static void dflag1(void) { deep(1); }
+static void dflag2(void) { deep(2); }
+static void dflag3(void) { deep(3); }
+
+static void at_hint(void) {
+	/* The first location with hint bits, no hints yet used */
+	for (loc_t loc = 1; loc <= NLOCATIONS; loc++) {
+		if (conditions[loc] >= base.conds) {
+			base.loc = base.newloc = loc;
+			return;
+		}
+	}
+}
+
+static void all_stashed(void) {
+	/* A well-scored game: every treasure found and stashed */
+	for (obj_t obj = 1; obj <= NOBJECTS; obj++) {
+		if (objects[obj].is_treasure) {
+			base.objects[obj].prop = STATE_FOUND;
+			base.objects[obj].place = LOC_BUILDING;
+		}
+	}
+	base.tally = 0;
+	base.dflag = 3;
+	base.closng = true;
+}
+
+/* Cases */
+
+static const char *line_words[] = {"get lamp", "n", "xyzzy", "throw axe",
+                                   NULL};
+
+static void run_get_command_input(void) {
+	command_t cmd = {0};
+	get_command_input(&cmd);
+}
+
+static void run_tokenize(void) {
+	static char raw[][LINESIZE] = {"get lamp", "n", "xyzzy", "throw axe"};
+	command_t cmd = {0};
+	tokenize(raw[iteration++ % 4], &cmd);
+}
+
+static void vocab(const char *word) {
+	vocab_t id;
+	word_type_t type;
+	get_vocab_metadata(word, &id, &type);
+}
+
+static void run_vocab_motion(void) { vocab("south"); }
+static void run_vocab_object(void) { vocab("lamp"); }
+static void run_vocab_action(void) { vocab("inventory"); }
+static void run_vocab_numeric(void) { vocab("1234"); }
+static void run_vocab_unknown(void) { vocab("frobozz"); }
+
+static void run_playermove_travel(void) {
+	reroll();
+	playermove(ENTER);
+}
+
+static void run_playermove_back(void) {
+	reroll();
+	playermove(BACK);
+}
+
+static void run_playermove_look(void) {
+	reroll();
+	playermove(LOOK);
+}
+
+static void run_playermove_cave(void) {
+	reroll();
+	playermove(CAVE);
+}
+
+static void run_playermove_blocked(void) {
+	reroll();
+	playermove(XYZZY);
+}
+
+static void run_playermove_maze(void) {
+	reroll();
+	playermove(SOUTH);
+}
+
+static void run_dwarfmove(void) {
+	reroll();
+	dwarfmove();
+}
+
+static void run_speak_plain(void) { rspeak(OK_MAN); }
+
+static void run_speak_numeric(void) { rspeak(TOTAL_SCORE, 32, 430, 4, 4); }
+
+static void run_speak_string(void) { sspeak(DO_WHAT, "Get"); }
+
+static void run_speak_object(void) { pspeak(LAMP, look, true, 0); }
+
+static void run_speak_long(void) {
+	speak(locations[LOC_START].description.big);
+}
+
+static void run_describe_location(void) {
+	reset();
+	describe_location();
+}
+
+static void run_listobjects(void) {
+	reset();
+	listobjects();
+}
+
+static void run_checkhints(void) {
+	reset();
+	checkhints();
+}
+
+static void run_score(void) { score(quitgame); }
+
+static void run_lcg_jump(void) {
+	game.lcg_x = lcg_jump(game.lcg_x, iteration * 40503);
+}
+
+static void run_lcg_distance(void) {
+	game.lcg_x = lcg_distance(game.lcg_x, (iteration * 40503) % LCG_M);
+}
+
+static void run_valid_actions(void) {
+	static int ids[VALID_IDS];
+	valid_actions(ids, VALID_IDS);
+}
+
+static char savebuf[sizeof(struct save_t)];
+
+static void run_savefile(void) {
+	FILE *fp = fmemopen(savebuf, sizeof(savebuf), "wb");
+	savefile(fp);
+	fclose(fp);
+}
+
+static void run_restore(void) {
+	restore(fmemopen(savebuf, sizeof(savebuf), "rb"));
+}
+
+static const struct {
+	const char *name;
+	void (*setup)(void);
+	void (*run)(void);
+} cases[] = {
+    {"reset", NULL, reset},
+    {"get_command_input", NULL, run_get_command_input},
+    {"tokenize", NULL, run_tokenize},
+    {"get_vocab_metadata/motion", NULL, run_vocab_motion},
+    {"get_vocab_metadata/object", NULL, run_vocab_object},
+    {"get_vocab_metadata/action", NULL, run_vocab_action},
+    {"get_vocab_metadata/numeric", NULL, run_vocab_numeric},
+    {"get_vocab_metadata/unknown", NULL, run_vocab_unknown},
+    {"playermove/travel", at_start, run_playermove_travel},
+    {"playermove/back", in_building, run_playermove_back},
+    {"playermove/look", in_building, run_playermove_look},
+    {"playermove/cave", at_start, run_playermove_cave},
+    {"playermove/blocked", at_start, run_playermove_blocked},
+    {"playermove/maze", in_maze, run_playermove_maze},
+    {"dwarfmove/dflag0", dflag0, run_dwarfmove},
+    {"dwarfmove/dflag1", dflag1, run_dwarfmove},
+    {"dwarfmove/dflag2", dflag2, run_dwarfmove},
+    {"dwarfmove/dflag3", dflag3, run_dwarfmove},
+    {"speak/plain", NULL, run_speak_plain},
+    {"speak/numeric", NULL, run_speak_numeric},
+    {"speak/string", NULL, run_speak_string},
+    {"speak/object", NULL, run_speak_object},
+    {"speak/long", NULL, run_speak_long},
+    {"describe_location", in_building, run_describe_location},
+    {"listobjects", in_building, run_listobjects},
+    {"checkhints", at_hint, run_checkhints},
+    {"score", all_stashed, run_score},
+    {"lcg_jump", NULL, run_lcg_jump},
+    {"lcg_distance", NULL, run_lcg_distance},
+    {"valid_actions", in_building, run_valid_actions},
+    {"savefile", in_building, run_savefile},
+    {"restore", in_building, run_restore},
+};
+
+static uint64_t check_lcg(void) {
+	/* Count where the LCG shortcuts disagree with straight stepping. */
+	static const int32_t starts[] = {0, 1, 12345, LCG_M - 1};
+	const uint64_t far = (uint64_t)0xffff * LCG_M * LCG_M; // whole periods
+	uint64_t mismatches = 0;
+
+	for (size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+		int64_t x = starts[s];
+		for (uint64_t n = 0; n <= LCG_M + LCG_M / 2; n++) {
+			if (lcg_jump(starts[s], n) != x ||
+			    lcg_distance(starts[s], x) != (int32_t)(n % LCG_M)) {
+				mismatches++;
+			}
+			/* A draw count far past 32 bits lands in the same place */
+			if (n % 4096 == 0 && lcg_jump(starts[s], n + far) != x) {
+				mismatches++;
+			}
+			x = (LCG_A * x + LCG_C) % LCG_M;
+		}
+	}
+	/* States outside the LCG's range have no distance */
+	mismatches += lcg_distance(0, LCG_M) != -1;
+	mismatches += lcg_distance(-1, 0) != -1;
+	mismatches += lcg_distance(LCG_M, LCG_M) != -1;
+	return mismatches;
+}
+
+static double timed(void (*run)(void), long calls) {
+	double t0 = now();
+	for (long i = 0; i < calls; i++) {
+		run();
+	}
+	return now() - t0;
+}
+
+static int compare(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+	double budget = 0.05; // seconds per timed run
+	const char *filter = NULL;
+	bool check = false;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "t:f:c")) != EOF) {
+		switch (ch) {
+		case 'c':
+			check = true;
+			break;
+		case 't':
+			budget = atof(optarg);
+			break;
+		case 'f':
+			filter = optarg;
+			break;
+		default:
+			fprintf(stderr,
+			        "Usage: %s [-t seconds-per-run] [-f substring] [-c]\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (check) {
+		uint64_t mismatches = check_lcg();
+		printf("%" PRIu64 " mismatches\n", mismatches);
+		return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	settings.outfp = fopen("/dev/null", "w");
+	if (settings.outfp == NULL) {
+		perror("/dev/null");
+		exit(EXIT_FAILURE);
+	}
+	initialise();
+	set_seed(1);
+	struct game_t start = game;
+
+	printf("{\n  \"version\": \"%s\",\n  \"unit\": \"ns/op\",\n", VERSION);
+	printf("  \"benchmarks\": [");
+	const char *sep = "\n";
+	for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+		if (filter != NULL && strstr(cases[c].name, filter) == NULL) {
+			continue;
+		}
+		base = start;
+		if (cases[c].setup != NULL) {
+			cases[c].setup();
+		}
+		game = base;
+		inputs = line_words;
+		iteration = 0;
+		if (cases[c].run == run_savefile || cases[c].run == run_restore) {
+			run_savefile();
+		}
+
+		/* Calibrate so each run takes about the budget */
+		long calls = 1;
+		double secs;
+		while ((secs = timed(cases[c].run, calls)) < budget / 10) {
+			calls *= 2;
+		}
+		calls = calls * budget / (secs > 0 ? secs : budget) + 1;
+
+		double ns[RUNS];
+		for (int r = 0; r < RUNS; r++) {
+			ns[r] = timed(cases[c].run, calls) * 1e9 / calls;
+		}
+		qsort(ns, RUNS, sizeof(double), compare);
+		printf("%s    {\"name\": \"%s\", \"calls\": %ld, "
+		       "\"median\": %.1f, \"min\": %.1f, \"max\": %.1f}",
+		       sep, cases[c].name, calls, ns[RUNS / 2], ns[0],
+		       ns[RUNS - 1]);
+		sep = ",\n";
+	}
+	printf("\n  ]\n}\n");
+	return EXIT_SUCCESS;
+}
+
+char *myreadline(const char *prompt) {
+	/* Hand out the bench's input lines round-robin. */
+	(void)prompt;
+	if (*inputs == NULL) {
+		inputs = line_words;
+	}
+	return strdup(*inputs++);
+}
+
+/* end */
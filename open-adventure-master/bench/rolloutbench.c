@@ -0,0 +1,197 @@
+/*
+ * rolloutbench - time decisions made by Monte-Carlo rollouts (see
+ * rollout.c), as a hint feature or a bot would make them.
+ *
+ * A game is started with the given seed and, at each decision, every
+ * command worth trying is valued by rollouts from the live game; the
+ * best by score, then by survival, is played.  When a game ends a new
+ * one starts with the next seed.  Reported are the decision latency,
+ * how many rollouts each decision got, and rollouts per second.  With
+ * -t, each decision stops starting rollouts when its budget is spent.
+ *
+ * With -c, each decision is also valued again on one thread and the
+ * two sets of values compared; with no budget, any difference is a bug.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAXCANDIDATES 512
+
+static THREAD_LOCAL const char *pending;
+
+char *myreadline(const char *prompt) {
+	/* Input comes through settings.readline. */
+	(void)prompt;
+	return NULL;
+}
+
+static char *bench_readline(const char *prompt) {
+	/* Hand over the chosen command once; then the step is done. */
+	const char *line = pending;
+
+	(void)prompt;
+	pending = NULL;
+	return line != NULL ? strdup(line) : NULL;
+}
+
+static bool bench_answer(const char *question) {
+	/* As the rollouts answer */
+	return question == NULL;
+}
+
+static bool step(const char *line, int32_t seed) {
+	/* Play line in the live game, or (line NULL) start a new game, up
+	 * to the next prompt; false if the game ended. */
+	jmp_buf over;
+	bool alive = true;
+
+	pending = line;
+	settings.exitjmp = &over;
+	if (setjmp(over) == 0) {
+		if (line == NULL) {
+			reset_command();
+			initialise();
+			set_seed(seed);
+			ZSET(game.novice, false);
+		} else {
+			await_command();
+		}
+		for (bool moving = line == NULL;; moving = true) {
+			if (moving && !do_move()) {
+				continue;
+			}
+			if (!do_command()) {
+				break;
+			}
+		}
+	} else {
+		alive = false;
+	}
+	settings.exitjmp = NULL;
+	return alive;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_double(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+	struct rollout_t how = {.rollouts = 100,
+	                        .horizon = 20,
+	                        .jobs = sysconf(_SC_NPROCESSORS_ONLN),
+	                        .seed = 1};
+	static struct rollout_value_t values[MAXCANDIDATES],
+	    again[MAXCANDIDATES];
+	int32_t seed = 1838473132;
+	long decisions = 20;
+	bool check = false;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "cd:j:k:n:s:t:")) != EOF) {
+		switch (ch) {
+		case 'c':
+			check = true;
+			break;
+		case 'd':
+			how.horizon = atoi(optarg);
+			break;
+		case 'j':
+			how.jobs = atoi(optarg);
+			break;
+		case 'k':
+			how.rollouts = atoi(optarg);
+			break;
+		case 'n':
+			decisions = atol(optarg);
+			break;
+		case 's':
+			seed = atol(optarg);
+			break;
+		case 't':
+			how.budget = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr,
+			        "Usage: %s [-c] [-d horizon] [-j threads] "
+			        "[-k rollouts] [-n decisions] [-s seed] "
+			        "[-t ms]\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (decisions < 1) {
+		decisions = 1;
+	}
+
+	memset(&settings, 0, sizeof(settings));
+	settings.silent = true;
+	settings.answer = bench_answer;
+	settings.readline = bench_readline;
+	step(NULL, seed);
+
+	double *latency = calloc(decisions, sizeof(double));
+	uint64_t runs = 0, mismatches = 0;
+	double busy = 0;
+	for (long d = 0; d < decisions; d++) {
+		double t0 = now();
+		size_t n = rollout_evaluate(&game, &how, values, MAXCANDIDATES);
+		latency[d] = now() - t0;
+		busy += latency[d];
+
+		size_t best = 0;
+		for (size_t c = 0; c < n; c++) {
+			runs += values[c].runs;
+			if (values[c].score > values[best].score ||
+			    (values[c].score == values[best].score &&
+			     values[c].survival > values[best].survival)) {
+				best = c;
+			}
+		}
+		if (check) {
+			struct rollout_t one = how;
+			one.jobs = 1;
+			if (rollout_evaluate(&game, &one, again, MAXCANDIDATES) != n ||
+			    memcmp(values, again, n * sizeof(values[0])) != 0) {
+				mismatches++;
+			}
+		}
+
+		char line[LINESIZE];
+		if (n == 0 || !valid_command(values[best].id, line, sizeof(line)) ||
+		    !step(line, 0)) {
+			step(NULL, ++seed);
+		}
+	}
+
+	qsort(latency, decisions, sizeof(double), compare_double);
+	printf("%ld decisions, %.0f rollouts each, horizon %d, %d threads\n",
+	       decisions, (double)runs / decisions, how.horizon, how.jobs);
+	printf("latency ms: median %.1f  p90 %.1f  max %.1f\n",
+	       latency[decisions / 2] * 1e3,
+	       latency[decisions - 1 - decisions / 10] * 1e3,
+	       latency[decisions - 1] * 1e3);
+	printf("%.0f rollouts/s\n", busy > 0 ? runs / busy : 0.0);
+	free(latency);
+	if (check) {
+		printf("%" PRIu64 " mismatches\n", mismatches);
+		return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/* end */
@@ -0,0 +1,304 @@
+/*
+ * serverload - drive advent-server over many connections and report
+ * turns per second and the latency of each turn, as players see it.
+ *
+ * Every session sends a random command each time the server's output
+ * ends in a prompt, weighted toward movement, with yes and no among
+ * them for questions.  A session the server closes (its game over) is
+ * replaced by a new one.  All sessions share one thread and one epoll
+ * set, so the client is unlikely to be what limits the run.
+ *
+ * With -s, one session plays a script instead, skipping comment lines,
+ * and what it saw is written to standard output with the lines it sent
+ * echoed after the prompts, as advent writes a transcript; with the
+ * script's input run out, the client half-closes and reads to the end.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAXSAMPLES 1000000
+
+static const char *commands[] = {
+    /* Movement, listed several times to weight it */
+    "n", "s", "e", "w", "ne", "nw", "se", "sw", "u", "d", "in", "out",
+    "n", "s", "e", "w", "u", "d", "west", "xyzzy", "plugh", "enter",
+    "upstream", "downstream", "forest", "valley", "building", "back",
+    "look",
+    /* Things to do along the way, and answers */
+    "get lamp", "light lamp", "get keys", "unlock grate", "open grate",
+    "get cage", "get bird", "get rod", "inven", "drop all", "get all",
+    "throw axe", "kill dwarf", "score", "wave rod", "yes", "no"};
+#define NCOMMANDS (int)(sizeof(commands) / sizeof(commands[0]))
+
+struct client_t {
+	int fd;
+	char tail[sizeof(PROMPT)]; // the last bytes received
+	double asked;              // when the last command went out
+};
+
+static struct sockaddr_storage addr;
+static socklen_t addrlen;
+
+char *myreadline(const char *prompt) {
+	/* Not used; the engine objects want it. */
+	(void)prompt;
+	return NULL;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t xorshift(uint32_t *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static bool address(const char *where, bool unix_socket) {
+	/* Where the server listens: a Unix path or [address:]port. */
+	memset(&addr, 0, sizeof(addr));
+	if (unix_socket) {
+		struct sockaddr_un *sun = (struct sockaddr_un *)&addr;
+		if (strlen(where) >= sizeof(sun->sun_path)) {
+			return false;
+		}
+		sun->sun_family = AF_UNIX;
+		strcpy(sun->sun_path, where);
+		addrlen = sizeof(*sun);
+		return true;
+	}
+	struct sockaddr_in *sin = (struct sockaddr_in *)&addr;
+	const char *colon = strrchr(where, ':');
+	char host[64] = "127.0.0.1";
+	if (colon != NULL) {
+		snprintf(host, sizeof(host), "%.*s", (int)(colon - where), where);
+		where = colon + 1;
+	}
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(atoi(where));
+	addrlen = sizeof(*sin);
+	return inet_pton(AF_INET, host, &sin->sin_addr) == 1;
+}
+
+static int dial(void) {
+	/* Connect, giving a server that is starting up a moment. */
+	for (int tries = 0; tries < 200; tries++) {
+		int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd < 0) {
+			return -1;
+		}
+		if (connect(fd, (struct sockaddr *)&addr, addrlen) == 0) {
+			return fd;
+		}
+		close(fd);
+		usleep(10000);
+	}
+	return -1;
+}
+
+static bool prompted(struct client_t *c, const char *buf, size_t n) {
+	/* Does the output so far end in a prompt? */
+	size_t keep = sizeof(c->tail) - 1;
+	char joined[sizeof(c->tail) + LINESIZE];
+	size_t have = strlen(c->tail);
+
+	if (n > LINESIZE) {
+		buf += n - LINESIZE;
+		n = LINESIZE;
+	}
+	memcpy(joined, c->tail, have);
+	memcpy(joined + have, buf, n);
+	have += n;
+	size_t from = have > keep ? have - keep : 0;
+	memcpy(c->tail, joined + from, have - from);
+	c->tail[have - from] = '\0';
+	return strcmp(c->tail, PROMPT) == 0;
+}
+
+static int script(const char *name) {
+	/* Play a script through one session, writing the transcript. */
+	FILE *fp = fopen(name, "r");
+	struct client_t c = {.fd = dial()};
+	char buf[LINESIZE];
+	bool more = true;
+
+	if (fp == NULL || c.fd < 0) {
+		perror(fp == NULL ? name : "serverload: connect");
+		return EXIT_FAILURE;
+	}
+	for (;;) {
+		ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+		if (n <= 0) {
+			break;
+		}
+		fwrite(buf, 1, n, stdout);
+		if (!more || !prompted(&c, buf, n)) {
+			continue;
+		}
+		char line[LINESIZE];
+		do {
+			more = fgets(line, sizeof(line), fp) != NULL;
+		} while (more && line[0] == '#');
+		if (more) {
+			fputs(line, stdout);
+			if (send(c.fd, line, strlen(line), MSG_NOSIGNAL) < 0) {
+				break;
+			}
+		} else {
+			shutdown(c.fd, SHUT_WR);
+		}
+	}
+	fclose(fp);
+	close(c.fd);
+	return EXIT_SUCCESS;
+}
+
+static bool join(int ep, struct client_t *c) {
+	/* Open a session for c. */
+	c->fd = dial();
+	c->tail[0] = '\0';
+	struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+	return c->fd >= 0 && epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev) == 0;
+}
+
+static int compare_double(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+	const char *where = NULL, *scriptname = NULL;
+	bool unix_socket = false;
+	long sessions = 100;
+	double seconds = 5;
+	uint32_t rng = 2463534242u;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "n:p:s:t:u:")) != EOF) {
+		switch (ch) {
+		case 'n':
+			sessions = atol(optarg);
+			break;
+		case 'p':
+			where = optarg;
+			unix_socket = false;
+			break;
+		case 's':
+			scriptname = optarg;
+			break;
+		case 't':
+			seconds = atof(optarg);
+			break;
+		case 'u':
+			where = optarg;
+			unix_socket = true;
+			break;
+		default:
+			where = NULL;
+			break;
+		}
+	}
+	if (where == NULL || !address(where, unix_socket)) {
+		fprintf(stderr,
+		        "Usage: %s [-n sessions] [-t seconds] [-s script] "
+		        "-p [address:]port | -u path\n",
+		        argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (scriptname != NULL) {
+		return script(scriptname);
+	}
+	if (sessions < 1) {
+		sessions = 1;
+	}
+
+	int ep = epoll_create1(EPOLL_CLOEXEC);
+	struct client_t *clients = calloc(sessions, sizeof(struct client_t));
+	double *latency = malloc(MAXSAMPLES * sizeof(double));
+	long turns = 0, games = sessions;
+	size_t samples = 0;
+	for (long i = 0; i < sessions; i++) {
+		if (!join(ep, &clients[i])) {
+			perror("serverload: connect");
+			exit(EXIT_FAILURE);
+		}
+		clients[i].asked = now();
+	}
+
+	double started = now(), stop = started + seconds;
+	struct epoll_event events[64];
+	char buf[65536];
+	while (now() < stop) {
+		int n = epoll_wait(ep, events, 64, 100);
+		for (int i = 0; i < n; i++) {
+			struct client_t *c = events[i].data.ptr;
+			ssize_t got = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT);
+			if (got < 0 && (errno == EAGAIN || errno == EINTR)) {
+				continue;
+			}
+			if (got <= 0) {
+				close(c->fd);
+				if (!join(ep, c)) {
+					perror("serverload: connect");
+					exit(EXIT_FAILURE);
+				}
+				c->asked = now();
+				games++;
+				continue;
+			}
+			if (!prompted(c, buf, got)) {
+				continue;
+			}
+			double t = now();
+			if (samples < MAXSAMPLES) {
+				latency[samples++] = t - c->asked;
+			}
+			turns++;
+			const char *cmd = commands[xorshift(&rng) % NCOMMANDS];
+			char line[LINESIZE];
+			snprintf(line, sizeof(line), "%s\n", cmd);
+			c->tail[0] = '\0';
+			c->asked = t;
+			if (send(c->fd, line, strlen(line), MSG_NOSIGNAL) < 0) {
+				c->tail[0] = '\0'; // the close shows up as a read
+			}
+		}
+	}
+	double elapsed = now() - started;
+
+	qsort(latency, samples, sizeof(double), compare_double);
+	printf("%ld sessions, %ld games, %ld turns in %.1f s: %.0f turns/s\n",
+	       sessions, games, turns, elapsed, turns / elapsed);
+	if (samples > 0) {
+		printf("latency ms: median %.3f  p99 %.3f  max %.3f\n",
+		       latency[samples / 2] * 1e3,
+		       latency[samples - 1 - samples / 100] * 1e3,
+		       latency[samples - 1] * 1e3);
+	}
+	for (long i = 0; i < sessions; i++) {
+		close(clients[i].fd);
+	}
+	free(clients);
+	free(latency);
+	return EXIT_SUCCESS;
+}
+
+/* end */
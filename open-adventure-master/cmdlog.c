@@ -0,0 +1,277 @@
+/*
+ * Binary command log.
+ *
+ * A compact alternative to the -l text log.  Each input line becomes
+ * one record:
+ *
+ *	varint (turn delta << 2 | nwords)
+ *		turn delta is game.turns minus that of the previous record,
+ *		zigzag-encoded because restoring a save can move it back
+ *		nwords 0 means a raw line follows, else 1 or 2 words
+ *	raw line:	varint length, then the bytes
+ *	each word:	varint code
+ *			even code: raw word of length code/2, bytes follow
+ *			odd code: vocabulary entry code/2, counting every
+ *			synonym of motions, then objects, then actions
+ *
+ * Words are only stored as vocabulary ids when the input spelling is
+ * exactly one of the dungeon's synonyms, so decoding is lossless and
+ * the result replays identically.  Lines that are not one or two
+ * words separated by a single blank are stored raw.
+ *
+ * Records accumulate in a per-session buffer and go out in groups of
+ * CMDLOG_GROUP, when the buffer fills, or on cmdlog_flush().
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "advent.h"
+
+#define CMDLOG_MAGIC "advent-cmdlog\n"
+#define CMDLOG_GROUP 32 // records buffered between flushes
+
+/* Vocabulary entries are numbered in this order of groups */
+static const string_group_t *vocab_group(int n) {
+	if (n < NMOTIONS) {
+		return &motions[n].words;
+	}
+	n -= NMOTIONS;
+	if (n <= NOBJECTS) {
+		return &objects[n].words;
+	}
+	n -= NOBJECTS + 1;
+	if (n < NACTIONS) {
+		return &actions[n].words;
+	}
+	return NULL;
+}
+
+void cmdlog_flush(struct cmdlog_t *log) {
+	if (log->fp == NULL) {
+		return;
+	}
+	if (log->len > 0) {
+		if (fwrite(log->buf, 1, log->len, log->fp) != log->len) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "advent: binary log write failed\n");
+			log->fp = NULL;
+			return;
+			// LCOV_EXCL_STOP
+		}
+		log->len = 0;
+	}
+	log->records = 0;
+	fflush(log->fp);
+}
+
+static void put_bytes(struct cmdlog_t *log, const void *data, size_t n) {
+	const unsigned char *p = data;
+	while (n > 0) {
+		if (log->len == sizeof(log->buf)) {
+			if (fwrite(log->buf, 1, log->len, log->fp) != log->len) {
+				return; // LCOV_EXCL_LINE
+			}
+			log->len = 0;
+		}
+		size_t chunk = sizeof(log->buf) - log->len;
+		if (chunk > n) {
+			chunk = n;
+		}
+		memcpy(log->buf + log->len, p, chunk);
+		log->len += chunk;
+		p += chunk;
+		n -= chunk;
+	}
+}
+
+static void put_varint(struct cmdlog_t *log, uint32_t val) {
+	unsigned char enc[5];
+	size_t n = 0;
+	do {
+		enc[n] = val & 0x7f;
+		val >>= 7;
+		if (val != 0) {
+			enc[n] |= 0x80;
+		}
+		n++;
+	} while (val != 0);
+	put_bytes(log, enc, n);
+}
+
+static void put_word(struct cmdlog_t *log, const char *word, size_t len) {
+	/* Emit a word as a vocabulary reference if its spelling is exact,
+	 * as raw bytes otherwise. */
+	const string_group_t *group;
+	uint32_t entry = 0;
+	for (int i = 0; (group = vocab_group(i)) != NULL; i++) {
+		for (int j = 0; j < group->n; j++, entry++) {
+			if (strncmp(group->strs[j], word, len) == 0 &&
+			    group->strs[j][len] == '\0') {
+				put_varint(log, entry << 1 | 1);
+				return;
+			}
+		}
+	}
+	put_varint(log, (uint32_t)len << 1);
+	put_bytes(log, word, len);
+}
+
+bool cmdlog_open(struct cmdlog_t *log, FILE *fp) {
+	/* Attach a log to an open file and write the header.  The header
+	 * carries the vocabulary sizes so a log is never decoded against
+	 * the wrong dungeon. */
+	log->fp = fp;
+	log->len = 0;
+	log->records = 0;
+	log->turn = 0;
+	if (fp == NULL) {
+		return false;
+	}
+	put_bytes(log, CMDLOG_MAGIC, sizeof(CMDLOG_MAGIC) - 1);
+	put_varint(log, NMOTIONS);
+	put_varint(log, NOBJECTS);
+	put_varint(log, NACTIONS);
+	return true;
+}
+
+void cmdlog_write(struct cmdlog_t *log, turn_t turn, const char *line) {
+	/* Append one input line to the log. */
+	if (log == NULL || log->fp == NULL) {
+		return;
+	}
+	size_t len = strlen(line);
+	const char *blank = memchr(line, ' ', len);
+	size_t len1 = blank ? (size_t)(blank - line) : len;
+	bool words = len > 0 && len1 > 0 && strchr(line, '\t') == NULL &&
+	             (blank == NULL ||
+	              (len1 + 1 < len && memchr(blank + 1, ' ', len - len1 - 1) ==
+	                                     NULL));
+
+	int32_t delta = turn - log->turn;
+	uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+	put_varint(log, zigzag << 2 | (words ? (blank ? 2 : 1) : 0));
+	log->turn = turn;
+	if (!words) {
+		put_varint(log, len);
+		put_bytes(log, line, len);
+	} else {
+		put_word(log, line, len1);
+		if (blank) {
+			put_word(log, blank + 1, len - len1 - 1);
+		}
+	}
+
+	if (++log->records >= CMDLOG_GROUP) {
+		cmdlog_flush(log);
+	}
+}
+
+void cmdlog_close(struct cmdlog_t *log) {
+	if (log->fp != NULL) {
+		cmdlog_flush(log);
+		fclose(log->fp);
+		log->fp = NULL;
+	}
+}
+
+/* Decoding */
+
+static bool get_varint(FILE *fp, uint32_t *val) {
+	*val = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		int c = getc(fp);
+		if (c == EOF) {
+			return false;
+		}
+		*val |= (uint32_t)(c & 0x7f) << shift;
+		if ((c & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false; // LCOV_EXCL_LINE
+}
+
+static bool get_raw(FILE *in, FILE *out, uint32_t len) {
+	while (len-- > 0) {
+		int c = getc(in);
+		if (c == EOF) {
+			return false;
+		}
+		putc(c, out);
+	}
+	return true;
+}
+
+static bool get_word(FILE *in, FILE *out) {
+	const string_group_t *group;
+	uint32_t code;
+
+	if (!get_varint(in, &code)) {
+		return false;
+	}
+	if ((code & 1) == 0) {
+		return get_raw(in, out, code >> 1);
+	}
+	code >>= 1;
+	for (int i = 0; (group = vocab_group(i)) != NULL; i++) {
+		if (code < (uint32_t)group->n) {
+			fputs(group->strs[code], out);
+			return true;
+		}
+		code -= group->n;
+	}
+	return false;
+}
+
+int cmdlog_decode(FILE *in, FILE *out) {
+	/* Convert a binary log back to the text format written by -l.
+	 * Returns the number of lines decoded, or -1 if the log is
+	 * malformed or was written against a different dungeon. */
+	char magic[sizeof(CMDLOG_MAGIC) - 1];
+	uint32_t nmotions, nobjects, nactions;
+
+	if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+	    memcmp(magic, CMDLOG_MAGIC, sizeof(magic)) != 0 ||
+	    !get_varint(in, &nmotions) || !get_varint(in, &nobjects) ||
+	    !get_varint(in, &nactions) || nmotions != NMOTIONS ||
+	    nobjects != NOBJECTS || nactions != NACTIONS) {
+		return -1;
+	}
+
+	int lines = 0;
+	for (;;) {
+		uint32_t head, len;
+		if (!get_varint(in, &head)) {
+			return lines;
+		}
+		switch (head & 3) {
+		case 0:
+			if (!get_varint(in, &len) || !get_raw(in, out, len)) {
+				return -1;
+			}
+			break;
+		case 1:
+			if (!get_word(in, out)) {
+				return -1;
+			}
+			break;
+		case 2:
+			if (!get_word(in, out) || putc(' ', out) == EOF ||
+			    !get_word(in, out)) {
+				return -1;
+			}
+			break;
+		default:
+			return -1;
+		}
+		putc('\n', out);
+		lines++;
+	}
+}
+
+/* end */
@@ -0,0 +1,118 @@
+/*
+ * Dungeon content coverage, kept by advent -C.
+ *
+ * A session sets one bit for each location it enters, each travel
+ * table entry it takes, each arbitrary message it speaks and each
+ * object state it reaches (checked at every prompt).  At exit the bits
+ * are appended to the coverage file as one fixed-size record:
+ *
+ *	magic "advent-cover 1\n" and a NUL
+ *	uint32 bits in each enum covergroup
+ *	the bitmap, group after group, in native byte order
+ *
+ * The record goes out in a single write(2) to a file opened O_APPEND,
+ * so any number of sessions may share one file without locking, and
+ * merging coverage from many hosts is concatenation.  advcover counts
+ * how many sessions reached each item.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "advent.h"
+
+#define COVER_MAGIC "advent-cover 1\n"
+
+static const uint32_t group_size[COVER_GROUPS] = {
+    [COVER_LOCATION] = NLOCATIONS + 1,
+    [COVER_TRAVEL] = NTRAVEL,
+    [COVER_MESSAGE] = NARBITRARY,
+    [COVER_STATE] = (NOBJECTS + 1) * (MAX_STATE + 1),
+};
+
+/* Where each group starts; the entry past the last is the total */
+static const size_t group_base[COVER_GROUPS + 1] = {
+    0,
+    NLOCATIONS + 1,
+    NLOCATIONS + 1 + NTRAVEL,
+    NLOCATIONS + 1 + NTRAVEL + NARBITRARY,
+    COVER_BITS,
+};
+
+struct coverrecord_t {
+	char magic[16];
+	uint32_t size[COVER_GROUPS];
+	struct coverage_t cover;
+};
+
+size_t coverage_index(enum covergroup group, int i) {
+	/* Bit number of a group's i'th item */
+	return group_base[group] + i;
+}
+
+void coverage_mark(struct coverage_t *cover, enum covergroup group, int i) {
+	/* Note that an item was reached; a no-op when coverage is off. */
+	if (cover == NULL || i < 0 || (uint32_t)i >= group_size[group]) {
+		return;
+	}
+	size_t bit = coverage_index(group, i);
+	cover->bits[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+void coverage_turn(struct coverage_t *cover, const struct game_t *g) {
+	/* Mark where the player is and the state of every object.  States
+	 * are set all over the code, so they are sampled here rather than
+	 * caught as they change. */
+	if (cover == NULL) {
+		return;
+	}
+	coverage_mark(cover, COVER_LOCATION, g->loc);
+	for (int obj = 1; obj <= NOBJECTS; obj++) {
+		int prop = g->objects[obj].prop;
+		if (prop == STATE_NOTFOUND) {
+			continue;
+		}
+		if (prop < 0) {
+			prop = PROP_STASHIFY(prop); // its own inverse
+		}
+		if (prop <= MAX_STATE) {
+			coverage_mark(cover, COVER_STATE,
+			              obj * (MAX_STATE + 1) + prop);
+		}
+	}
+}
+
+bool coverage_save(const struct coverage_t *cover, int fd) {
+	/* Append a session's record to fd, which should be O_APPEND. */
+	struct coverrecord_t rec;
+
+	memset(&rec, 0, sizeof(rec));
+	memcpy(rec.magic, COVER_MAGIC, sizeof(COVER_MAGIC));
+	memcpy(rec.size, group_size, sizeof(group_size));
+	rec.cover = *cover;
+	return write(fd, &rec, sizeof(rec)) == (ssize_t)sizeof(rec);
+}
+
+int coverage_load(struct coverage_t *cover, FILE *fp) {
+	/* Read the next record.  Returns 1 on success, 0 at end of file,
+	 * or -1 if the record is short or from a different dungeon. */
+	struct coverrecord_t rec;
+	size_t got = fread(&rec, 1, sizeof(rec), fp);
+
+	if (got == 0 && feof(fp)) {
+		return 0;
+	}
+	if (got != sizeof(rec) ||
+	    memcmp(rec.magic, COVER_MAGIC, sizeof(COVER_MAGIC)) != 0 ||
+	    memcmp(rec.size, group_size, sizeof(group_size)) != 0) {
+		return -1;
+	}
+	*cover = rec.cover;
+	return 1;
+}
+
+/* end */
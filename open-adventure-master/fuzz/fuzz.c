@@ -0,0 +1,497 @@
+/*
+ * fuzz - persistent-mode fuzzer for the command pipeline and restore.
+ *
+ * Every input runs in this process, starting from the same game state
+ * (fresh start, seed 1, novice question answered) with a struct copy.
+ * An input beginning with the save-file magic is a save_t blob: it is
+ * fed to restore(), which checks it with is_valid(), and a few fixed
+ * commands are then played against whatever state it produced.
+ * Anything else is command lines, played through get_command_input(),
+ * preprocess_command() and action() exactly as advent does, until they
+ * run out or the game ends.
+ *
+ * A crash, or a bug() inside the engine, writes the input to
+ * crash-<exec> in the current directory and aborts.  Run the fuzzer on
+ * that file with -n 0 to reproduce it.  The driver itself works in a
+ * scratch directory under /tmp, so that save files the inputs ask for
+ * land there.
+ *
+ * The stand-alone driver mutates a seed corpus (see "make fuzz-corpus")
+ * with a dictionary of the dungeon's vocabulary.  The engine objects are
+ * built with -fsanitize-coverage=trace-pc, and any input that reaches a
+ * new edge, or an old one a new number of times, joins the corpus.
+ * Built with -DFUZZ_LIBFUZZER and clang's -fsanitize=fuzzer, only
+ * LLVMFuzzerTestOneInput() is compiled in, and libFuzzer drives it.
+ *
+ * Nothing is set up again between inputs; each starts from a struct copy
+ * of the initialised game.  What an exec costs is the game it plays:
+ * every command goes through the whole turn, a few thousand coverage
+ * callbacks' worth.  On one core that is some 600 execs/s from the test
+ * logs, which are whole games, and 10-20 thousand with -m 64 or less,
+ * so -m is the knob for rate against depth; no cap brings a game that
+ * plays its commands to hundreds of thousands a second.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAXLEN 4096 // longest input the mutator can make
+
+static struct game_t start; // state every input begins from
+static FILE *devnull;
+
+/* The input being run, and the lines myreadline() is handing out */
+static const uint8_t *unit;
+static size_t unitlen;
+static const uint8_t *input;
+static size_t inputlen, inputpos;
+
+/* Played after a restore, to exercise the state it produced */
+static const char after_restore[] = "inven\nlook\nscore\nn\ns\n";
+
+char *myreadline(const char *prompt) {
+	/* Next line of the input, without its newline. */
+	(void)prompt;
+	if (inputpos >= inputlen) {
+		return NULL;
+	}
+	const uint8_t *line = input + inputpos;
+	const uint8_t *end = memchr(line, '\n', inputlen - inputpos);
+	size_t len = (end != NULL ? end : input + inputlen) - line;
+	char *copy = malloc(len + 1);
+	memcpy(copy, line, len);
+	copy[len] = '\0';
+	inputpos += len + (end != NULL);
+	return copy;
+}
+
+static void play(FILE *rfp) {
+	/* Restore if asked, then play as main() does until the game ends
+	 * or input runs out.  bug() counts as a crash. */
+	jmp_buf over;
+
+	settings.exitjmp = &over;
+	int status = setjmp(over);
+	if (status == 0) {
+		if (rfp != NULL) {
+			restore(rfp);
+		}
+		for (;;) {
+			if (!do_move()) {
+				continue;
+			}
+			if (!do_command()) {
+				break;
+			}
+		}
+		terminate(quitgame);
+	} else if (status == EXIT_FAILURE + 1) {
+		abort();
+	}
+}
+
+static void setup(void) {
+	devnull = fopen("/dev/null", "w");
+	settings.outfp = devnull;
+	initialise();
+	set_seed(1);
+	game.novice = false;
+	start = game;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	/* Run one input from the common starting state. */
+	static struct save_t blob;
+	FILE *rfp = NULL;
+
+	if (devnull == NULL) {
+		setup();
+	}
+	unit = data;
+	unitlen = size;
+	game = start;
+	zobrist_rehash();
+	reset_command();
+	settings.outfp = devnull;
+
+	if (size >= sizeof(ADVENT_MAGIC) - 1 &&
+	    memcmp(data, ADVENT_MAGIC, sizeof(ADVENT_MAGIC) - 1) == 0) {
+		memset(&blob, 0, sizeof(blob));
+		memcpy(&blob, data, size < sizeof(blob) ? size : sizeof(blob));
+		rfp = fmemopen(&blob, sizeof(blob), "rb");
+		input = (const uint8_t *)after_restore;
+		inputlen = sizeof(after_restore) - 1;
+	} else {
+		input = data;
+		inputlen = size;
+	}
+	inputpos = 0;
+	play(rfp);
+	return 0;
+}
+
+#if !defined FUZZ_LIBFUZZER
+
+/* Edge coverage, fed by -fsanitize-coverage=trace-pc in the engine */
+#define MAPSIZE 65536
+
+static uint8_t trace[MAPSIZE];
+static uint8_t seen[MAPSIZE]; // count classes ever hit, per edge
+static uintptr_t prevpc;
+
+void __sanitizer_cov_trace_pc(void);
+void __sanitizer_cov_trace_pc(void) {
+	uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+	trace[(pc ^ prevpc) & (MAPSIZE - 1)]++;
+	prevpc = pc >> 1;
+}
+
+static uint8_t count_class(uint8_t hits) {
+	/* Bucket hit counts as AFL does: 1, 2, 3, 4-7, 8-15, ... */
+	if (hits <= 3) {
+		return hits == 3 ? 4 : hits;
+	}
+	uint8_t class = 8;
+	for (int n = hits >> 3; n != 0 && class != 128; n >>= 1) {
+		class <<= 1;
+	}
+	return class;
+}
+
+static int news(void) {
+	/* Fold this run's trace into seen[]; count the novelties. */
+	int found = 0;
+	uint64_t *words = (uint64_t *)trace;
+	for (size_t w = 0; w < MAPSIZE / sizeof(uint64_t); w++) {
+		if (words[w] == 0) {
+			continue;
+		}
+		for (size_t i = w * 8; i < w * 8 + 8; i++) {
+			uint8_t class = count_class(trace[i]);
+			if (class != 0 && (seen[i] & class) == 0) {
+				seen[i] |= class;
+				found++;
+			}
+		}
+		words[w] = 0;
+	}
+	prevpc = 0;
+	return found;
+}
+
+static int edges(void) {
+	int n = 0;
+	for (size_t i = 0; i < MAPSIZE; i++) {
+		n += seen[i] != 0;
+	}
+	return n;
+}
+
+/* Corpus */
+
+struct unit_t {
+	uint8_t *data;
+	size_t size;
+};
+
+static struct unit_t *corpus;
+static size_t ncorpus, corpus_alloc;
+
+static void keep(const uint8_t *data, size_t size) {
+	if (ncorpus == corpus_alloc) {
+		corpus_alloc = corpus_alloc ? corpus_alloc * 2 : 256;
+		corpus = realloc(corpus, corpus_alloc * sizeof(*corpus));
+	}
+	corpus[ncorpus].data = malloc(size ? size : 1);
+	memcpy(corpus[ncorpus].data, data, size);
+	corpus[ncorpus].size = size;
+	ncorpus++;
+}
+
+static void load_file(const char *path) {
+	FILE *fp = fopen(path, "rb");
+	uint8_t buf[MAXLEN * 4];
+
+	if (fp == NULL) {
+		perror(path);
+		return;
+	}
+	size_t size = fread(buf, 1, sizeof(buf), fp);
+	fclose(fp);
+	keep(buf, size);
+}
+
+static void load(const char *path) {
+	/* A corpus file, or every file in a corpus directory */
+	DIR *dir = opendir(path);
+	struct dirent *ent;
+
+	if (dir == NULL) {
+		load_file(path);
+		return;
+	}
+	while ((ent = readdir(dir)) != NULL) {
+		char name[PATH_MAX];
+		struct stat st;
+		snprintf(name, sizeof(name), "%s/%s", path, ent->d_name);
+		if (stat(name, &st) == 0 && S_ISREG(st.st_mode)) {
+			load_file(name);
+		}
+	}
+	closedir(dir);
+}
+
+/* Mutation */
+
+static uint64_t rng = 88172645463325252ull;
+
+static uint64_t rnd(uint64_t n) {
+	rng ^= rng << 13;
+	rng ^= rng >> 7;
+	rng ^= rng << 17;
+	return n ? rng % n : 0;
+}
+
+static const char **dict;
+static size_t ndict;
+static size_t maxlen = MAXLEN; // longest input it does make; see -m
+
+static void add_words(const string_group_t *words) {
+	for (int i = 0; i < words->n; i++) {
+		dict = realloc(dict, (ndict + 1) * sizeof(*dict));
+		dict[ndict++] = words->strs[i];
+	}
+}
+
+static void build_dict(void) {
+	/* Every word the parser knows */
+	for (int i = 0; i < NMOTIONS; i++) {
+		add_words(&motions[i].words);
+	}
+	for (int i = 0; i <= NOBJECTS; i++) {
+		add_words(&objects[i].words);
+	}
+	for (int i = 0; i < NACTIONS; i++) {
+		add_words(&actions[i].words);
+	}
+}
+
+static size_t insert(uint8_t *buf, size_t len, size_t at, const void *src,
+                     size_t n) {
+	if (len + n > maxlen) {
+		n = len < maxlen ? maxlen - len : 0;
+	}
+	memmove(buf + at + n, buf + at, len - at);
+	memcpy(buf + at, src, n);
+	return len + n;
+}
+
+static size_t mutate(uint8_t *buf, size_t len) {
+	/* Apply one to four random edits in place. */
+	static const int32_t interesting[] = {
+	    0, 1, -1, 2, 100, 127, 128, 255, 256, 32767, 32768, 65535, 65536,
+	    INT32_MAX, INT32_MIN};
+	int edits = 1 + rnd(4);
+
+	while (edits-- > 0) {
+		size_t at = rnd(len + 1);
+		switch (rnd(len ? 8 : 3)) {
+		case 0: { /* a vocabulary word, maybe a whole command */
+			const char *word = dict[rnd(ndict)];
+			len = insert(buf, len, at, word, strlen(word));
+			if (rnd(2) && len < maxlen) {
+				char sep = rnd(2) ? ' ' : '\n';
+				len = insert(buf, len, at + strlen(word), &sep, 1);
+			}
+			break;
+		}
+		case 1: /* a line break */
+			len = insert(buf, len, at, "\n", 1);
+			break;
+		case 2: { /* splice in part of another unit */
+			const struct unit_t *u = &corpus[rnd(ncorpus)];
+			size_t from = rnd(u->size), n = 1 + rnd(u->size - from);
+			if (u->size > 0) {
+				len = insert(buf, len, at, u->data + from, n);
+			}
+			break;
+		}
+		case 3: /* flip a bit */
+			buf[rnd(len)] ^= 1 << rnd(8);
+			break;
+		case 4: /* random byte */
+			buf[rnd(len)] = rnd(256);
+			break;
+		case 5: { /* delete a run */
+			size_t from = rnd(len), n = 1 + rnd(len - from);
+			if (n > 16) {
+				n = 1 + rnd(16);
+			}
+			if (from + n > len) {
+				n = len - from;
+			}
+			memmove(buf + from, buf + from + n, len - from - n);
+			len -= n;
+			break;
+		}
+		case 6: { /* duplicate a run */
+			size_t from = rnd(len), n = 1 + rnd(len - from);
+			uint8_t run[MAXLEN];
+			memcpy(run, buf + from, n);
+			len = insert(buf, len, at, run, n);
+			break;
+		}
+		case 7: { /* an interesting 32-bit value, for saves */
+			int32_t val = interesting[rnd(sizeof(interesting) /
+			                              sizeof(interesting[0]))];
+			if (len >= sizeof(val)) {
+				memcpy(buf + rnd(len - sizeof(val) + 1), &val,
+				       sizeof(val));
+			}
+			break;
+		}
+		}
+	}
+	return len;
+}
+
+/* Crashes */
+
+static long execs;
+static char crashdir[PATH_MAX];
+
+static void crash_handler(int signo) {
+	/* Save the input that did it, then die of the same signal. */
+	char name[PATH_MAX + 32];
+	snprintf(name, sizeof(name), "%s/crash-%ld", crashdir, execs);
+	const char msg[] = "fuzz: crash, input saved\n";
+	int fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd >= 0) {
+		if (write(fd, unit, unitlen) < 0 ||
+		    write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0) {
+			/* nothing more we can do */
+		}
+		close(fd);
+	}
+	signal(signo, SIG_DFL);
+	raise(signo);
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+	long maxexecs = -1;
+	double seconds = 0;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "m:n:t:s:")) != EOF) {
+		switch (ch) {
+		case 'm':
+			maxlen = atol(optarg);
+			if (maxlen < 1 || maxlen > MAXLEN) {
+				maxlen = MAXLEN;
+			}
+			break;
+		case 'n':
+			maxexecs = atol(optarg);
+			break;
+		case 't':
+			seconds = atof(optarg);
+			break;
+		case 's':
+			rng = strtoull(optarg, NULL, 0) | 1;
+			break;
+		default:
+			fprintf(stderr,
+			        "Usage: %s [-m bytes] [-n execs] [-t seconds] "
+			        "[-s seed] corpus...\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	char scratch[] = "/tmp/advent-fuzz.XXXXXX";
+	if (getcwd(crashdir, sizeof(crashdir)) == NULL ||
+	    mkdtemp(scratch) == NULL) {
+		perror("fuzz");
+		exit(EXIT_FAILURE);
+	}
+
+	signal(SIGSEGV, crash_handler);
+	signal(SIGBUS, crash_handler);
+	signal(SIGFPE, crash_handler);
+	signal(SIGABRT, crash_handler);
+	setup();
+	build_dict();
+	for (int i = optind; i < argc; i++) {
+		load(argv[i]);
+	}
+	if (chdir(scratch) != 0) {
+		perror(scratch);
+		exit(EXIT_FAILURE);
+	}
+
+	/* Seeds first; -n 0 stops after them */
+	size_t seeds = ncorpus;
+	for (size_t i = 0; i < seeds; i++) {
+		execs++;
+		LLVMFuzzerTestOneInput(corpus[i].data, corpus[i].size);
+		news();
+	}
+	if (ncorpus == 0) {
+		keep((const uint8_t *)"", 0);
+	}
+
+	double t0 = now(), last = t0;
+	uint8_t buf[MAXLEN];
+	long found = 0;
+	while (maxexecs < 0 || execs < maxexecs) {
+		const struct unit_t *u = &corpus[rnd(ncorpus)];
+		size_t len = u->size < maxlen ? u->size : maxlen;
+		memcpy(buf, u->data, len);
+		len = mutate(buf, len);
+
+		execs++;
+		LLVMFuzzerTestOneInput(buf, len);
+		if (news() > 0) {
+			keep(buf, len);
+			found++;
+		}
+
+		if ((execs & 1023) == 0) {
+			double t = now();
+			if (t - last >= 1 || (seconds > 0 && t - t0 >= seconds)) {
+				fprintf(stderr,
+				        "fuzz: %ld execs, %.0f/s, corpus %zu "
+				        "(+%ld), %d edges\n",
+				        execs, execs / (t - t0), ncorpus, found,
+				        edges());
+				last = t;
+				if (seconds > 0 && t - t0 >= seconds) {
+					break;
+				}
+			}
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+#endif
+
+/* end */
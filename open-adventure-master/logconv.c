@@ -0,0 +1,52 @@
+/*
+ * 'logconv' converts a binary command log written by advent -b back
+ * into the text format written by -l, which is what the test suite
+ * and script arguments consume.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[]) {
+	int ch;
+	FILE *in = stdin, *out = stdout;
+	const char *usage = "Usage: %s [-o textlogfile] [binarylogfile]\n";
+
+	while ((ch = getopt(argc, argv, "o:")) != EOF) {
+		switch (ch) {
+		case 'o':
+			out = fopen(optarg, "w");
+			if (out == NULL) {
+				fprintf(stderr, "Can't open file %s. Exiting.\n",
+				        optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		default:
+			fprintf(stderr, usage, argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (optind < argc) {
+		in = fopen(argv[optind], READ_MODE);
+		if (in == NULL) {
+			fprintf(stderr, "Can't open file %s. Exiting.\n",
+			        argv[optind]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (cmdlog_decode(in, out) < 0) {
+		fprintf(stderr, "logconv: malformed or incompatible log\n");
+		exit(EXIT_FAILURE);
+	}
+
+	fclose(out);
+	return EXIT_SUCCESS;
+}
+
+/* end */
@@ -237,6 +237,7 @@ def get_obituaries(obit):
 
 def get_hints(hnt):
     template = """    {{
+        .name = "{}",
         .number = {},
         .penalty = {},
         .turns = {},
@@ -252,20 +253,24 @@ def get_hints(hnt):
         turns = item["turns"]
         question = make_c_string(item["question"])
         hint = make_c_string(item["hint"])
-        hnt_str += template.format(number, penalty, turns, question, hint)
+        hnt_str += template.format(
+            item["name"].lower(), number, penalty, turns, question, hint
+        )
     hnt_str = hnt_str[:-1]  # trim trailing newline
     return hnt_str
 
 
-def get_condbits(locations):
+def get_condbits(locations, forced):
     cnd_str = ""
-    for (name, loc) in locations:
+    for (i, (name, loc)) in enumerate(locations):
         conditions = loc["conditions"]
         hints = loc.get("hints") or []
         flaglist = []
         for flag in conditions:
             if conditions[flag]:
                 flaglist.append(flag)
+        if i in forced:
+            flaglist.append("FORCED")
         line = "|".join([("(1<<COND_%s)" % f) for f in flaglist])
         trail = "|".join([("(1<<COND_H%s)" % f["name"]) for f in hints])
         if trail:
@@ -566,6 +571,102 @@ def buildtravel(locs, objs):
     return (travel, tkey)
 
 
+def get_forced(locs, travel, tkey):
+    "Locations whose first travel rule is an unconditional forced move."
+    forced = set()
+    for i in range(1, len(locs)):
+        if locs[i][1]["description"]["long"] is None or i >= len(tkey):
+            continue
+        motion = travel[tkey[i]][2]
+        if tkey[i] != 0 and motion in ("HERE", motionnames.index("HERE")):
+            forced.add(i)
+    return forced
+
+
+def get_initial_game(locs, objs):
+    """Replay what initialise() used to do at every startup: thread the
+    objects onto the per-location atloc lists, mark unseen treasures and
+    count them.  Returns initializer text for the tables of struct game_t."""
+    nobjects = len(objs) - 1
+    atloc = [0] * len(locs)
+    link = [0] * (2 * nobjects + 1)
+    place = [0] * (nobjects + 1)
+    fixed = [0] * (nobjects + 1)
+    plac = [0] * (nobjects + 1)
+    fixd = [0] * (nobjects + 1)
+
+    def objname(o):
+        if o > nobjects:
+            return "%s + NOBJECTS" % objnames[o - nobjects]
+        return objnames[o]
+
+    def locname(where):
+        if where == -1:
+            return "IS_FIXED"
+        return locnames[where]
+
+    def drop(obj, where):
+        if obj > nobjects:
+            fixed[obj - nobjects] = where
+        else:
+            place[obj] = where
+        if where <= 0:
+            return
+        link[obj] = atloc[where]
+        atloc[where] = obj
+
+    for (i, (_, attr)) in enumerate(objs):
+        locations = attr.get("locations", ["LOC_NOWHERE", "LOC_NOWHERE"])
+        if isinstance(locations, str):
+            plac[i] = locnames.index(locations)
+            fixd[i] = -1 if attr.get("immovable", False) else 0
+        else:
+            plac[i] = locnames.index(locations[0])
+            fixd[i] = locnames.index(locations[1])
+
+    # Same order as the original loops, so the lists come out the same
+    for i in range(nobjects, 0, -1):
+        if fixd[i] > 0:
+            drop(i + nobjects, fixd[i])
+            drop(i, plac[i])
+    for i in range(1, nobjects + 1):
+        k = nobjects + 1 - i
+        fixed[k] = fixd[k]
+        if plac[k] != 0 and fixd[k] <= 0:
+            drop(k, plac[k])
+
+    tally = 0
+    props = ["STATE_FOUND"] * (nobjects + 1)
+    for i in range(1, nobjects + 1):
+        if objs[i][1].get("treasure"):
+            tally += 1
+            if objs[i][1]["inventory"] is not None:
+                props[i] = "STATE_NOTFOUND"
+
+    out = "    .tally = %d,\n" % tally
+    out += "    .dwarves = {\n"
+    for (i, loc) in enumerate(db["dwarflocs"]):
+        out += "        [%d] = {.loc = %s},\n" % (i + 1, loc)
+    out += "    },\n    .objects = {\n"
+    for i in range(1, nobjects + 1):
+        out += "        [%s] = {.fixed = %s, .prop = %s, .place = %s},\n" % (
+            objnames[i],
+            "IS_FREE" if fixed[i] == 0 else locname(fixed[i]),
+            props[i],
+            locname(place[i]),
+        )
+    out += "    },\n    .locs = {\n"
+    for (i, obj) in enumerate(atloc):
+        if obj:
+            out += "        [%s] = {.atloc = %s},\n" % (locnames[i], objname(obj))
+    out += "    },\n    .link = {\n"
+    for (i, obj) in enumerate(link):
+        if obj:
+            out += "        [%s] = %s,\n" % (objname(i), objname(obj))
+    out += "    },"
+    return out
+
+
 def get_travel(travel):
     template = """    {{ // from {}: {}
         .motion = {},
@@ -620,13 +721,16 @@ if __name__ == "__main__":
         objects=get_objects(db["objects"]),
         obituaries=get_obituaries(db["obituaries"]),
         hints=get_hints(db["hints"]),
-        conditions=get_condbits(db["locations"]),
+        conditions=get_condbits(
+            db["locations"], get_forced(db["locations"], travel, tkey)
+        ),
         motions=get_motions(db["motions"]),
         actions=get_actions(db["actions"]),
         tkeys=bigdump(tkey),
         travel=get_travel(travel),
         ignore=ignore,
         dwarflocs=", ".join(db["dwarflocs"]) + ",",
+        initial_game=get_initial_game(db["locations"], db["objects"]),
     )
 
     # 0-origin index of birds's last song.  Bird should
@@ -644,6 +748,7 @@ if __name__ == "__main__":
         num_actions=len(db["actions"]),
         num_travel=len(travel),
         num_keys=len(tkey),
+        num_arbitrary=len(db["arbitrary_messages"]),
         bird_endstate=deathbird,
         arbitrary_messages=get_refs(db["arbitrary_messages"]),
         locations=get_refs(db["locations"]),
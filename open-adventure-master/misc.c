@@ -36,8 +36,8 @@ static void *xcalloc(size_t size) {
 
 static void vspeak(const char *msg, bool blank, va_list ap) {
 	/* Engine for various speak functions */
-	// Do nothing if we got a null pointer.
-	if (msg == NULL) {
+	// Do nothing if we got a null pointer, or are to be silent.
+	if (msg == NULL || settings.silent) {
 		return;
 	}
 
@@ -46,8 +46,10 @@ static void vspeak(const char *msg, bool blank, va_list ap) {
 		return;
 	}
 
+	int64_t start = profile_start();
+
 	if (blank == true) {
-		printf("\n");
+		fputc('\n', settings.outfp);
 	}
 
 	int msglen = strlen(msg);
@@ -122,9 +124,10 @@ static void vspeak(const char *msg, bool blank, va_list ap) {
 	*renderp = 0;
 
 	// Print the message.
-	printf("%s\n", rendered);
+	fprintf(settings.outfp, "%s\n", rendered);
 
 	free(rendered);
+	profile_stop(PHASE_OUTPUT, 0, start);
 }
 
 void speak(const char *msg, ...) {
@@ -139,9 +142,15 @@ void sspeak(const int msg, ...) {
 	/* Speak a message from the arbitrary-messages list */
 	va_list ap;
 	va_start(ap, msg);
-	fputc('\n', stdout);
-	vprintf(arbitrary_messages[msg], ap);
-	fputc('\n', stdout);
+	coverage_mark(settings.coverage, COVER_MESSAGE, msg);
+	if (settings.heard != NULL) {
+		settings.heard(msg);
+	}
+	if (!settings.silent) {
+		fputc('\n', settings.outfp);
+		vfprintf(settings.outfp, arbitrary_messages[msg], ap);
+		fputc('\n', settings.outfp);
+	}
 	va_end(ap);
 }
 
@@ -177,18 +186,19 @@ void rspeak(vocab_t i, ...) {
 	/* Print the i-th "random" message (section 6 of database). */
 	va_list ap;
 	va_start(ap, i);
+	coverage_mark(settings.coverage, COVER_MESSAGE, i);
+	if (settings.heard != NULL) {
+		settings.heard(i);
+	}
 	vspeak(arbitrary_messages[i], true, ap);
 	va_end(ap);
 }
 
 void echo_input(FILE *destination, const char *input_prompt,
                 const char *input) {
-	size_t len = strlen(input_prompt) + strlen(input) + 1;
-	char *prompt_and_input = (char *)xcalloc(len);
-	strcpy(prompt_and_input, input_prompt);
-	strcat(prompt_and_input, input);
-	fprintf(destination, "%s\n", prompt_and_input);
-	free(prompt_and_input);
+	fputs(input_prompt, destination);
+	fputs(input, destination);
+	fputc('\n', destination);
 }
 
 static int word_count(char *str) {
@@ -220,11 +230,20 @@ static char *get_input(void) {
 	}
 
 	// Print a blank line
-	printf("\n");
+	if (!settings.silent) {
+		fputc('\n', settings.outfp);
+	}
+
+	transcript_turn(settings.transcript);
+	coverage_turn(settings.coverage, &game);
+	zobrist_check();
+	observe_check();
 
 	char *input;
 	for (;;) {
-		input = myreadline(input_prompt);
+		input = settings.readline != NULL
+		            ? settings.readline(input_prompt)
+		            : myreadline(input_prompt);
 
 		if (input == NULL) { // Got EOF; return with it.
 			return (input);
@@ -240,29 +259,37 @@ static char *get_input(void) {
 	// Strip trailing newlines from the input
 	input[strcspn(input, "\n")] = 0;
 
-	add_history(input);
-
-	if (!isatty(0)) {
-		echo_input(stdout, input_prompt, input);
+	if (settings.interactive) {
+		if (settings.readline == NULL) {
+			add_history(input); // libedit's own history
+		}
+	} else if (!settings.silent) {
+		echo_input(settings.outfp, input_prompt, input);
 	}
 
 	if (settings.logfp) {
 		echo_input(settings.logfp, "", input);
 	}
 
+	cmdlog_write(settings.cmdlog, game.turns, input);
+
 	return (input);
 }
 
 bool silent_yes_or_no(void) {
 	bool outcome = false;
 
+	if (settings.answer != NULL) {
+		return settings.answer(NULL);
+	}
+
 	for (;;) {
 		char *reply = get_input();
 		if (reply == NULL) {
 			// LCOV_EXCL_START
 			// Should be unreachable. Reply should never be NULL
 			free(reply);
-			exit(EXIT_SUCCESS);
+			session_exit(EXIT_SUCCESS);
 			// LCOV_EXCL_STOP
 		}
 		if (strlen(reply) == 0) {
@@ -303,9 +330,17 @@ bool silent_yes_or_no(void) {
 bool yes_or_no(const char *question, const char *yes_response,
                const char *no_response) {
 	/*  Print message X, wait for yes/no answer.  If yes, print Y and return
-	 * true; if no, print Z and return false. */
+	 * true; if no, print Z and return false.  A host may answer in
+	 * place of the player through settings.answer. */
 	bool outcome = false;
 
+	if (settings.answer != NULL) {
+		speak(question);
+		outcome = settings.answer(question);
+		speak(outcome ? yes_response : no_response);
+		return outcome;
+	}
+
 	for (;;) {
 		speak(question);
 
@@ -314,7 +349,7 @@ bool yes_or_no(const char *question, const char *yes_response,
 			// LCOV_EXCL_START
 			// Should be unreachable. Reply should never be NULL
 			free(reply);
-			exit(EXIT_SUCCESS);
+			session_exit(EXIT_SUCCESS);
 			// LCOV_EXCL_STOP
 		}
 
@@ -434,8 +469,7 @@ static bool is_valid_int(const char *str) {
 	return true;
 }
 
-static void get_vocab_metadata(const char *word, vocab_t *id,
-                               word_type_t *type) {
+void get_vocab_metadata(const char *word, vocab_t *id, word_type_t *type) {
 	/* Check for an empty string */
 	if (strncmp(word, "", sizeof("")) == 0) {
 		*id = WORD_EMPTY;
@@ -487,7 +521,7 @@ static void get_vocab_metadata(const char *word, vocab_t *id,
 	return;
 }
 
-static void tokenize(char *raw, command_t *cmd) {
+void tokenize(char *raw, command_t *cmd) {
 	/*
 	 * Be careful about modifying this. We do not want to nuke the
 	 * the speech part or ID from the previous turn.
@@ -559,9 +593,12 @@ bool get_command_input(command_t *command) {
 	}
 
 	strncpy(inputbuf, input, LINESIZE - 1);
+	inputbuf[LINESIZE - 1] = '\0';
 	free(input);
 
+	int64_t start = profile_start();
 	tokenize(inputbuf, command);
+	profile_stop(PHASE_TOKENIZE, 0, start);
 
 #ifdef GDEBUG
 	/* Needs to stay synced with enum word_type_t */
@@ -569,8 +606,8 @@ bool get_command_input(command_t *command) {
 	                       "NUMERIC"};
 	/* needs to stay synced with enum speechpart */
 	const char *roles[] = {"unknown", "intransitive", "transitive"};
-	printf(
-	    "Command: role = %s type1 = %s, id1 = %d, type2 = %s, id2 = %d\n",
+	fprintf(
+	    settings.outfp, "Command: role = %s type1 = %s, id1 = %d, type2 = %s, id2 = %d\n",
 	    roles[command->part], types[command->word[0].type],
 	    command->word[0].id, types[command->word[1].type],
 	    command->word[1].id);
@@ -584,7 +621,7 @@ void clear_command(command_t *cmd) {
 	/* Resets the state of the command to empty */
 	cmd->verb = ACT_NULL;
 	cmd->part = unknown;
-	game.oldobj = cmd->obj;
+	ZSET(game.oldobj, cmd->obj);
 	cmd->obj = NO_OBJECT;
 	cmd->state = EMPTY;
 }
@@ -638,11 +675,13 @@ void carry(obj_t object, loc_t where) {
 	 * or game.holdng. */
 	int temp;
 
+	PROBE(carry, object, where);
+
 	if (object <= NOBJECTS) {
 		if (game.objects[object].place == CARRIED) {
 			return;
 		}
-		game.objects[object].place = CARRIED;
+		ZSET(game.objects[object].place, CARRIED);
 
 		/*
 		 * Without this conditional your inventory is overcounted
@@ -652,26 +691,27 @@ void carry(obj_t object, loc_t where) {
 		 * Possibly this check should be skipped whwn oldstyle is on.
 		 */
 		if (object != BIRD) {
-			++game.holdng;
+			ZSET(game.holdng, game.holdng + 1);
 		}
 	}
 	if (game.locs[where].atloc == object) {
-		game.locs[where].atloc = game.link[object];
+		ZSET(game.locs[where].atloc, game.link[object]);
 		return;
 	}
 	temp = game.locs[where].atloc;
 	while (game.link[temp] != object) {
 		temp = game.link[temp];
 	}
-	game.link[temp] = game.link[object];
+	ZSET(game.link[temp], game.link[object]);
 }
 
 void drop(obj_t object, loc_t where) {
 	/*  Place an object at a given loc, prefixing it onto the game atloc
 	 * list.  Decr game.holdng if the object was being toted. No state
 	 * change on the object. */
+	PROBE(drop, object, where);
 	if (object > NOBJECTS) {
-		game.objects[object - NOBJECTS].fixed = where;
+		ZSET(game.objects[object - NOBJECTS].fixed, where);
 	} else {
 		if (game.objects[object].place == CARRIED) {
 			if (object != BIRD) {
@@ -682,16 +722,16 @@ void drop(obj_t object, loc_t where) {
 				 * either 'take bird' or 'take cage' and have
 				 * the right thing happen.
 				 */
-				--game.holdng;
+				ZSET(game.holdng, game.holdng - 1);
 			}
 		}
-		game.objects[object].place = where;
+		ZSET(game.objects[object].place, where);
 	}
 	if (where == LOC_NOWHERE || where == CARRIED) {
 		return;
 	}
-	game.link[object] = game.locs[where].atloc;
-	game.locs[where].atloc = object;
+	ZSET(game.link[object], game.locs[where].atloc);
+	ZSET(game.locs[where].atloc, object);
 }
 
 int atdwrf(loc_t where) {
@@ -717,7 +757,7 @@ int atdwrf(loc_t where) {
 }
 
 /*  Utility routines (setbit, tstbit, set_seed, get_next_lcg_value,
- *  randrange) */
+ *  randrange, and skipping about in the LCG's sequence) */
 
 int setbit(int bit) {
 	/*  Returns 2**bit for use in constructing bit-masks. */
@@ -731,44 +771,124 @@ bool tstbit(int mask, int bit) {
 
 void set_seed(int32_t seedval) {
 	/* Set the LCG1 seed */
-	game.lcg_x = seedval % LCG_M;
+	ZSET(game.lcg_x, seedval % LCG_M);
 	if (game.lcg_x < 0) {
-		game.lcg_x = LCG_M + game.lcg_x;
+		ZSET(game.lcg_x, LCG_M + game.lcg_x);
 	}
 	// once seed is set, we need to generate the Z`ZZZ word
 	for (int i = 0; i < 5; ++i) {
-		game.zzword[i] = 'A' + randrange(26);
+		ZSET(game.zzword[i], 'A' + randrange(26));
 	}
-	game.zzword[1] = '\''; // force second char to apostrophe
-	game.zzword[5] = '\0';
+	ZSET(game.zzword[1], '\''); // force second char to apostrophe
+	ZSET(game.zzword[5], '\0');
 }
 
 static int32_t get_next_lcg_value(void) {
 	/* Return the LCG's current value, and then iterate it. */
 	int32_t old_x = game.lcg_x;
-	game.lcg_x = (LCG_A * game.lcg_x + LCG_C) % LCG_M;
-	if (settings.debug) {
-		printf("# random %d\n", old_x); // LCOV_EXCL_LINE
-	}
+	ZSET(game.lcg_x, (LCG_A * game.lcg_x + LCG_C) % LCG_M);
 	return old_x;
 }
 
-int32_t randrange(int32_t range) {
-	/* Return a random integer from [0, range). */
-	return range * get_next_lcg_value() / LCG_M;
+int32_t randrange_at(int32_t range, const char *func, int line) {
+	/* Return a random integer from [0, range), noting the draw in the
+	 * trace if there is one.  Call it as randrange(range). */
+	int32_t value = get_next_lcg_value();
+	struct rngtrace_t *trace = settings.rngtrace;
+	if (trace != NULL) {
+		struct rngdraw_t *draw =
+		    &trace->ring[trace->draws++ & (RNGTRACE_SIZE - 1)];
+		draw->func = func;
+		draw->line = line;
+		draw->turn = game.turns;
+		draw->range = range;
+		draw->value = value;
+	}
+	return range * value / LCG_M;
+}
+
+int32_t lcg_jump(int32_t x, uint64_t draws) {
+	/* The LCG state draws steps on from x, in O(log draws) steps.
+	 * Stepping n times is x -> A^n x + C (A^(n-1) + ... + 1); square
+	 * the one-step map for each bit of n and apply the maps for the
+	 * bits that are set.  All arithmetic is mod LCG_M, a power of two,
+	 * so the sequence has period LCG_M and only draws % LCG_M matters. */
+	int64_t a = LCG_A, c = LCG_C;
+
+	for (draws %= LCG_M; draws != 0; draws >>= 1) {
+		if (draws & 1) {
+			x = (a * x + c) % LCG_M;
+		}
+		c = (a + 1) * c % LCG_M;
+		a = a * a % LCG_M;
+	}
+	return x;
+}
+
+int32_t lcg_distance(int32_t from, int32_t to) {
+	/* How many draws take the LCG from state from to state to.  The
+	 * period is full, so there is exactly one answer below LCG_M; it
+	 * is found a bit at a time, lowest first, by stepping from with
+	 * the squared maps of lcg_jump() wherever the states differ in
+	 * the bit in hand.  Returns -1 if either is not an LCG state. */
+	int64_t a = LCG_A, c = LCG_C, x = from;
+	int32_t draws = 0;
+
+	if (from < 0 || from >= LCG_M || to < 0 || to >= LCG_M) {
+		return -1;
+	}
+	for (uint32_t bit = 1; x != to && bit < LCG_M; bit <<= 1) {
+		if ((x ^ to) & bit) {
+			x = (a * x + c) % LCG_M;
+			draws |= bit;
+		}
+		c = (a + 1) * c % LCG_M;
+		a = a * a % LCG_M;
+	}
+	return draws;
+}
+
+int32_t rng_tell(void) {
+	/* The RNG's position.  The LCG state is all there is to it. */
+	return game.lcg_x;
+}
+
+void rng_seek(int32_t position) {
+	/* Put the RNG back where rng_tell() found it.  The Z'ZZZ word set
+	 * by set_seed() stays as it is. */
+	ZSET(game.lcg_x, position);
+}
+
+void rng_skip(uint64_t draws) {
+	/* Move the RNG on as if randrange() had been called draws times.
+	 * Parallel replays can split one seed into independent streams by
+	 * starting each a fixed stride of draws, LCG_M / streams, apart. */
+	ZSET(game.lcg_x, lcg_jump(game.lcg_x, draws));
 }
 
 // LCOV_EXCL_START
 void bug(enum bugtype num, const char *error_string) {
 	fprintf(stderr, "Fatal error %d, %s.\n", num, error_string);
-	exit(EXIT_FAILURE);
+	session_exit(EXIT_FAILURE);
 }
 // LCOV_EXCL_STOP
 
+void session_exit(int status) {
+	/* End the current game.  A host running games in-process catches
+	 * this through settings.exitjmp, where setjmp() returns status + 1;
+	 * otherwise the process exits. */
+	transcript_turn(settings.transcript);
+	if (settings.exitjmp != NULL) {
+		longjmp(*settings.exitjmp, status + 1);
+	}
+	exit(status);
+}
+
 void state_change(obj_t obj, int state) {
 	/* Object must have a change-message list for this to be useful; only
 	 * some do */
-	game.objects[obj].prop = state;
+	PROBE(state__change, obj, state);
+	ZSET(game.objects[obj].prop, state);
 	pspeak(obj, change, true, state);
 }
 
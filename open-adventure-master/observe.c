@@ -0,0 +1,185 @@
+/*
+ * A fixed-length numeric observation of the live game, for agents.
+ *
+ * A host attaches an int32_t buffer of OBS_SIZE entries (laid out by
+ * enum observation in advent.h) with observe_attach(), which fills it;
+ * from then on ZSET() calls observe_field() before and after each write
+ * to the game, and only the entries that field feeds are brought up to
+ * date.  Sums, such as the score, have the field's share taken out
+ * before the write and put back after it, the way zobrist.c toggles
+ * hash keys; everything else is set from the new value.
+ *
+ * The visible set is the atloc chain at the player's location, so it is
+ * walked again when the player moves, when the light changes, or when a
+ * link on that chain is written.  Chains are a few objects long; no
+ * write ever costs a scan of the whole game.
+ *
+ * Built with -DADVENT_OBSERVE_CHECK (as "make debug" does),
+ * observe_check() rebuilds the observation from scratch at every prompt
+ * and treats any difference as a bug.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "advent.h"
+
+#define MEMBERWORDS ((NOBJECTS * 2 + 32) / 32)
+
+THREAD_LOCAL int32_t *game_observation;
+
+/* The object-list entries on the chain at the player's location */
+static THREAD_LOCAL uint32_t members[MEMBERWORDS];
+
+static void set_bit(int32_t *words, int bit, bool on) {
+	uint32_t mask = 1u << (bit % 32);
+	uint32_t word = (uint32_t)words[bit / 32];
+	words[bit / 32] = (int32_t)(on ? word | mask : word & ~mask);
+}
+
+static void see(int32_t *obs, uint32_t *chain) {
+	/* Set the darkness bit and walk the chain here for the visible set. */
+	memset(&obs[OBS_VISIBLE], 0, OBS_SETWORDS * sizeof(int32_t));
+	memset(chain, 0, MEMBERWORDS * sizeof(uint32_t));
+	obs[OBS_DARK] = IS_DARK_HERE();
+	if (obs[OBS_DARK]) {
+		return;
+	}
+	for (int i = game.locs[game.loc].atloc; i != 0; i = game.link[i]) {
+		chain[i / 32] |= 1u << (i % 32);
+		set_bit(&obs[OBS_VISIBLE], i > NOBJECTS ? i - NOBJECTS : i, true);
+	}
+}
+
+static void count_dwarves(int32_t *obs) {
+	/* Who is at the player's location. */
+	obs[OBS_DWARVES] = 0;
+	for (int i = 1; i < PIRATE; i++) {
+		obs[OBS_DWARVES] += game.dwarves[i].loc == game.loc;
+	}
+	obs[OBS_PIRATE] = game.dwarves[PIRATE].loc == game.loc;
+}
+
+static void build(int32_t *obs, uint32_t *chain) {
+	/* The observation of the live game, from scratch. */
+	memset(obs, 0, OBS_SIZE * sizeof(int32_t));
+	obs[OBS_LOC] = game.loc;
+	obs[OBS_LAMP] = game.limit;
+	obs[OBS_SCORE] = score_standing();
+	for (int i = 1; i <= NOBJECTS; i++) {
+		set_bit(&obs[OBS_CARRIED], i, TOTING(i));
+		obs[OBS_PROP + i] = game.objects[i].prop;
+		obs[OBS_SCORE] += score_object(i);
+	}
+	count_dwarves(obs);
+	see(obs, chain);
+}
+
+void observe_full(int32_t *obs) {
+	/* Fill obs with an observation of the live game, built from
+	 * scratch; the attached one, if any, is left alone. */
+	uint32_t chain[MEMBERWORDS];
+
+	build(obs, chain);
+}
+
+void observe_attach(int32_t *obs) {
+	/* Keep obs up to date with the live game from now on, or stop
+	 * keeping any observation if obs is NULL. */
+	game_observation = obs;
+	observe_rehash();
+}
+
+void observe_rehash(void) {
+	/* Resynchronize after the live game was overwritten wholesale. */
+	if (game_observation != NULL) {
+		build(game_observation, members);
+	}
+}
+
+void observe_field(const void *field, int sign) {
+	/* Update the attached observation for a write to one field of the
+	 * live game: sign is -1 just before the write, +1 just after. */
+	int32_t *obs = game_observation;
+	ptrdiff_t offset = (const char *)field - (const char *)&game;
+
+#define IN(array)                                                              \
+	(offset >= (ptrdiff_t)offsetof(struct game_t, array) &&                \
+	 offset < (ptrdiff_t)(offsetof(struct game_t, array) +                 \
+	                      sizeof(game.array)))
+#define INDEX(array)                                                           \
+	((offset - (ptrdiff_t)offsetof(struct game_t, array)) /                \
+	 (ptrdiff_t)sizeof(game.array[0]))
+	if (IN(objects)) {
+		obj_t obj = INDEX(objects);
+		obs[OBS_SCORE] += sign * score_object(obj);
+		if (sign < 0) {
+			return;
+		}
+		set_bit(&obs[OBS_CARRIED], obj, TOTING(obj));
+		obs[OBS_PROP + obj] = game.objects[obj].prop;
+		if (obj == LAMP) {
+			see(obs, members);
+		}
+	} else if (IN(link)) {
+		int i = INDEX(link);
+		if (sign > 0 && members[i / 32] & 1u << (i % 32)) {
+			see(obs, members);
+		}
+	} else if (IN(locs)) {
+		if (sign > 0 && INDEX(locs) == game.loc) {
+			see(obs, members);
+		}
+	} else if (IN(dwarves)) {
+		if (sign > 0) {
+			count_dwarves(obs);
+		}
+	} else if (IN(hints)) {
+		obs[OBS_SCORE] += sign * score_standing();
+	} else {
+		switch (offset) {
+		case offsetof(struct game_t, loc):
+			if (sign > 0) {
+				obs[OBS_LOC] = game.loc;
+				count_dwarves(obs);
+				see(obs, members);
+			}
+			break;
+		case offsetof(struct game_t, limit):
+			obs[OBS_LAMP] = game.limit;
+			break;
+		case offsetof(struct game_t, numdie):
+		case offsetof(struct game_t, dflag):
+		case offsetof(struct game_t, closng):
+		case offsetof(struct game_t, closed):
+		case offsetof(struct game_t, bonus):
+		case offsetof(struct game_t, novice):
+		case offsetof(struct game_t, clshnt):
+		case offsetof(struct game_t, trnluz):
+		case offsetof(struct game_t, saved):
+			obs[OBS_SCORE] += sign * score_standing();
+			break;
+		}
+	}
+#undef IN
+#undef INDEX
+}
+
+void observe_check(void) {
+	/* In checking builds, die if the observation has drifted. */
+#if defined ADVENT_OBSERVE_CHECK
+	int32_t fresh[OBS_SIZE];
+	if (game_observation == NULL) {
+		return;
+	}
+	observe_full(fresh);
+	if (memcmp(fresh, game_observation, sizeof(fresh)) != 0) {
+		BUG(OBSERVATION_OUT_OF_STEP_WITH_GAME_STATE); // LCOV_EXCL_LINE
+	}
+#endif
+}
+
+/* end */
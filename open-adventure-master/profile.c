@@ -0,0 +1,203 @@
+/*
+ * Per-phase turn profiler, enabled by advent -T.
+ *
+ * Each timed phase of a turn (see enum phase) records its wall-clock
+ * duration into a power-of-two histogram: bucket k counts calls that
+ * took at least 2^k and less than 2^(k+1) nanoseconds.  Verb dispatch
+ * through action() is also broken down per verb.  Phases nest, so a
+ * phase's time includes that of any phase it calls: do_move includes
+ * dwarfmove, and nearly everything includes output.
+ *
+ * When profiling is off, profile_start() is one test of a flag and
+ * profile_stop() another.
+ *
+ * profile_report() formats numbers itself into a stack buffer and
+ * write()s it, with no stdio, so a host may call it from a signal
+ * handler to see a running game.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "advent.h"
+
+#define BUCKETS 32 // the last one also holds everything slower
+
+struct histogram_t {
+	uint64_t calls;
+	uint64_t total; // nanoseconds
+	uint64_t bucket[BUCKETS];
+};
+
+static const char *phase_names[PHASE_COUNT] = {
+    [PHASE_MOVE] = "do_move",
+    [PHASE_DWARFMOVE] = "dwarfmove",
+    [PHASE_DESCRIBE] = "describe_location",
+    [PHASE_LISTOBJECTS] = "listobjects",
+    [PHASE_CHECKHINTS] = "checkhints",
+    [PHASE_TOKENIZE] = "tokenize",
+    [PHASE_ACTION] = "action",
+    [PHASE_LAMPCHECK] = "lampcheck",
+    [PHASE_CLOSECHECK] = "closecheck",
+    [PHASE_OUTPUT] = "output",
+};
+
+static THREAD_LOCAL struct histogram_t phases[PHASE_COUNT];
+static THREAD_LOCAL struct histogram_t verbs[NACTIONS];
+
+static int64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int64_t profile_start(void) {
+	/* Timestamp for profile_stop(), or 0 when not profiling. */
+	return settings.profile ? now_ns() : 0;
+}
+
+static void record(struct histogram_t *h, uint64_t ns) {
+	int k = 0;
+	while (k < BUCKETS - 1 && ns >> (k + 1) != 0) {
+		k++;
+	}
+	h->calls++;
+	h->total += ns;
+	h->bucket[k]++;
+}
+
+void profile_stop(enum phase phase, int verb, int64_t start) {
+	/* Record a phase that began at start.  verb picks the per-verb
+	 * histogram for PHASE_ACTION and is ignored otherwise. */
+	if (start == 0) {
+		return;
+	}
+	uint64_t ns = now_ns() - start;
+	record(&phases[phase], ns);
+	if (phase == PHASE_ACTION && verb >= 0 && verb < NACTIONS) {
+		record(&verbs[verb], ns);
+	}
+}
+
+/* Output being put together for write(); no stdio, which isn't
+ * async-signal-safe */
+struct out_t {
+	int fd;
+	size_t len;
+	char buf[256];
+};
+
+static void drain(struct out_t *o) {
+	if (o->len > 0 && write(o->fd, o->buf, o->len) < 0) {
+		o->len = 0; // LCOV_EXCL_LINE
+	}
+	o->len = 0;
+}
+
+static void out_str(struct out_t *o, const char *s, int width) {
+	/* s, padded to width: on the left if width > 0, else on the right */
+	size_t n = strlen(s), pad = 0, w = width < 0 ? -width : width;
+	if (n < w) {
+		pad = w - n;
+	}
+	if (o->len + n + pad > sizeof(o->buf)) {
+		drain(o);
+	}
+	if (n + pad > sizeof(o->buf)) {
+		return; // LCOV_EXCL_LINE
+	}
+	if (width > 0) {
+		memset(o->buf + o->len, ' ', pad);
+		o->len += pad;
+	}
+	memcpy(o->buf + o->len, s, n);
+	o->len += n;
+	if (width < 0) {
+		memset(o->buf + o->len, ' ', pad);
+		o->len += pad;
+	}
+}
+
+static void out_u64(struct out_t *o, uint64_t v, int width) {
+	char digits[21], *p = digits + sizeof(digits) - 1;
+	*p = '\0';
+	do {
+		*--p = '0' + v % 10;
+		v /= 10;
+	} while (v != 0);
+	out_str(o, p, width);
+}
+
+static uint64_t quantile(const struct histogram_t *h, double q) {
+	/* Upper bound of the bucket holding quantile q, in ns */
+	uint64_t want = h->calls * q, seen = 0;
+	for (int k = 0; k < BUCKETS; k++) {
+		seen += h->bucket[k];
+		if (seen > want) {
+			return (uint64_t)1 << (k + 1);
+		}
+	}
+	return (uint64_t)1 << BUCKETS; // LCOV_EXCL_LINE
+}
+
+static void show(struct out_t *o, const char *prefix, const char *name,
+                 const struct histogram_t *h) {
+	if (h->calls == 0) {
+		return;
+	}
+	out_str(o, prefix, 0);
+	out_str(o, name, -22);
+	out_str(o, " ", 0);
+	out_u64(o, h->calls, 10);
+	out_str(o, " ", 0);
+	out_u64(o, h->total / h->calls, 10);
+	out_str(o, " ", 0);
+	out_u64(o, quantile(h, 0.5), 10);
+	out_str(o, " ", 0);
+	out_u64(o, quantile(h, 0.99), 10);
+	out_str(o, "\n", 0);
+	out_str(o, prefix, 0);
+	out_str(o, "  ", 0);
+	for (int k = 0; k < BUCKETS; k++) {
+		if (h->bucket[k] != 0) {
+			out_str(o, " <", 0);
+			out_u64(o, (uint64_t)1 << (k + 1), 0);
+			out_str(o, ":", 0);
+			out_u64(o, h->bucket[k], 0);
+		}
+	}
+	out_str(o, "\n", 0);
+}
+
+void profile_report(int fd) {
+	/* Dump every non-empty histogram to fd. */
+	static const char *heads[] = {"calls", "mean ns", "p50 < ns",
+	                              "p99 < ns"};
+	struct out_t o = {.fd = fd};
+
+	out_str(&o, "profile: ", 0);
+	out_str(&o, "phase", -22);
+	for (size_t i = 0; i < sizeof(heads) / sizeof(heads[0]); i++) {
+		out_str(&o, " ", 0);
+		out_str(&o, heads[i], 10);
+	}
+	out_str(&o, "\n", 0);
+	for (int i = 0; i < PHASE_COUNT; i++) {
+		show(&o, "profile: ", phase_names[i], &phases[i]);
+		if (i != PHASE_ACTION) {
+			continue;
+		}
+		for (int v = 0; v < NACTIONS; v++) {
+			const string_group_t *words = &actions[v].words;
+			show(&o, "profile:   ", words->n > 0 ? words->strs[0] : "-",
+			     &verbs[v]);
+		}
+	}
+	drain(&o);
+}
+
+/* end */
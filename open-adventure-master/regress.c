@@ -0,0 +1,713 @@
+/*
+ * 'regress' runs the game logs in tests/ inside one process and checks
+ * each transcript against its .chk file, emitting TAP the way the
+ * per-log tapdiffer rules in tests/Makefile do.
+ *
+ * Every log is a separate game with its own engine state.  Games run
+ * on a pool of threads; logs named stem.1.log, stem.2.log ... form a
+ * chain that runs in order on one thread, because later members resume
+ * games the earlier ones saved.  Results are reported in name order
+ * whatever order they finish in.
+ *
+ * With -H, a test whose stem.hash file holds transcript hash records
+ * (see transcript.c) is first replayed with its output hashed and
+ * thrown away; only if the records differ is it played again for a
+ * text diff, which is then annotated with the first prompt at which
+ * the records diverged.  -w writes stem.hash for every test that
+ * passes.
+ *
+ * With -O, each game keeps an observation (see observe.c) that is
+ * checked against one built from scratch at every prompt; a test whose
+ * observation drifts fails even if its transcript matches.
+ *
+ * With -S, each test is played a second time in silent mode (see
+ * settings.silent), starting from the spoken run's clock seed, and the
+ * whole of the game state is hashed at every prompt of both runs; a
+ * test whose silent game strays from the spoken one fails even if its
+ * transcript matches.
+ *
+ * With -V, every command valid_actions() offers at each prompt is
+ * spelled out by valid_command() and put through the parser; a test at
+ * which one of them comes back as a word the parser does not know
+ * fails even if its transcript matches.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <ctype.h>
+#include <getopt.h>
+#include <glob.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAXSCRIPTS 4
+
+/* Tests fed from several script files, mirroring multifile-regress */
+static const struct {
+	const char *name;
+	const char *legend;
+	const char *check;
+	const char *scripts[MAXSCRIPTS]; // "-" stands for input below
+	const char *input;
+} multifiles[] = {
+    {"multifile", "multiple-file test", "multifile.chk",
+     {"issue36.log", "-"}, "inven\n"},
+};
+
+struct source_t {
+	char *text;
+	size_t len;
+	size_t pos;
+};
+
+struct test_t {
+	char *name;
+	char *legend;
+	char *options; // from the #options: line, if any
+	struct source_t source[MAXSCRIPTS];
+	int nsources;
+	bool scripted; // sources are script arguments, not standard input
+	char *expect;
+	size_t expectlen;
+	char *output;
+	size_t outputlen;
+	char *hashes; // expected transcript records, from stem.hash
+	size_t hasheslen;
+	char *records; // this run's transcript records
+	size_t recordslen;
+	int chain; // index of the first test in this one's chain
+	int prompts; // prompts reached in this run
+	int drift;   // prompt where the observation first drifted, or 0
+	uint64_t *states; // game_hash() at each prompt of the spoken run
+	int nstates;
+	int strayed; // prompt where the silent run first differed, or 0
+	int seed;    // the spoken run's clock seed, for the silent run
+	int unparsed; // prompt where a valid action first failed to parse, or 0
+	bool ok;
+};
+
+static struct test_t *tests;
+static int ntests;
+static int nextchain;
+static pthread_mutex_t chainlock = PTHREAD_MUTEX_INITIALIZER;
+static bool hashcheck; // -H: compare transcript hashes first
+static bool hashwrite; // -w: write stem.hash for passing tests
+static bool observecheck; // -O: check incremental observations
+static bool silentcheck; // -S: check that silent play matches
+static bool validcheck; // -V: check that valid actions parse
+
+/* The test a thread is playing; myreadline() reads from it */
+static THREAD_LOCAL struct test_t *current;
+static THREAD_LOCAL int cursource;
+
+static char *slurp(const char *name, size_t *len) {
+	FILE *fp = fopen(name, "rb");
+	char *buf = NULL;
+	size_t size = 0;
+
+	if (fp == NULL) {
+		return NULL;
+	}
+	for (;;) {
+		buf = realloc(buf, size + BUFSIZ + 1);
+		if (buf == NULL) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Out of memory!\n");
+			exit(EXIT_FAILURE);
+			// LCOV_EXCL_STOP
+		}
+		size_t got = fread(buf + size, 1, BUFSIZ, fp);
+		size += got;
+		if (got < BUFSIZ) {
+			break;
+		}
+	}
+	fclose(fp);
+	buf[size] = '\0';
+	*len = size;
+	return buf;
+}
+
+static char *header_line(const char *text, const char *tag) {
+	/* Copy out the rest of the first line starting with tag. */
+	for (const char *line = text; line != NULL && *line != '\0';) {
+		const char *end = strchr(line, '\n');
+		size_t len = end ? (size_t)(end - line) : strlen(line);
+		if (strncmp(line, tag, strlen(tag)) == 0) {
+			return strndup(line + strlen(tag), len - strlen(tag));
+		}
+		line = end ? end + 1 : NULL;
+	}
+	return NULL;
+}
+
+static bool add_log(const char *log) {
+	struct test_t *t = &tests[ntests];
+	size_t len;
+	char check[FILENAME_MAX];
+
+	memset(t, 0, sizeof(*t));
+	t->source[0].text = slurp(log, &len);
+	if (t->source[0].text == NULL) {
+		fprintf(stderr, "regress: can't read %s\n", log);
+		return false;
+	}
+	t->source[0].len = len;
+	t->nsources = 1;
+	t->name = strndup(log, strlen(log) - strlen(".log"));
+	t->legend = header_line(t->source[0].text, "## ");
+	t->options = header_line(t->source[0].text, "#options:");
+	snprintf(check, sizeof(check), "%s.chk", t->name);
+	t->expect = slurp(check, &t->expectlen);
+	if (hashcheck) {
+		snprintf(check, sizeof(check), "%s.hash", t->name);
+		t->hashes = slurp(check, &t->hasheslen);
+	}
+	ntests++;
+	return true;
+}
+
+static void add_multifile(int i) {
+	struct test_t *t = &tests[ntests];
+
+	memset(t, 0, sizeof(*t));
+	t->name = strdup(multifiles[i].name);
+	t->legend = strdup(multifiles[i].legend);
+	t->scripted = true;
+	for (int j = 0; j < MAXSCRIPTS && multifiles[i].scripts[j]; j++) {
+		struct source_t *s = &t->source[t->nsources++];
+		if (strcmp(multifiles[i].scripts[j], "-") == 0) {
+			s->text = strdup(multifiles[i].input);
+			s->len = strlen(s->text);
+		} else if ((s->text = slurp(multifiles[i].scripts[j],
+		                            &s->len)) == NULL) {
+			return; // script missing, so is the test
+		}
+	}
+	t->expect = slurp(multifiles[i].check, &t->expectlen);
+	t->chain = ntests++; // a chain of its own
+}
+
+static void chain_tests(void) {
+	/* stem.N logs share their predecessor's chain. */
+	for (int i = 0; i < ntests; i++) {
+		tests[i].chain = i;
+		const char *dot = strrchr(tests[i].name, '.');
+		if (i == 0 || dot == NULL || !isdigit((unsigned char)dot[1]) ||
+		    strspn(dot + 1, "0123456789") != strlen(dot + 1)) {
+			continue;
+		}
+		size_t stem = dot - tests[i].name;
+		const char *prev = tests[i - 1].name;
+		const char *pdot = strrchr(prev, '.');
+		if (pdot != NULL && (size_t)(pdot - prev) == stem &&
+		    strncmp(prev, tests[i].name, stem) == 0) {
+			tests[i].chain = tests[i - 1].chain;
+		}
+	}
+}
+
+static void note_state(void) {
+	/* Record the game state at this prompt, or in a silent run compare
+	 * it with what the spoken run recorded. */
+	struct test_t *t = current;
+	uint64_t hash = game_hash();
+
+	if (!settings.silent) {
+		t->states = realloc(t->states, (t->nstates + 1) * sizeof(uint64_t));
+		t->states[t->nstates++] = hash;
+	} else if (t->strayed == 0 &&
+	           (t->prompts > t->nstates || t->states[t->prompts - 1] != hash)) {
+		t->strayed = t->prompts;
+	}
+}
+
+static bool all_parse(void) {
+	/* Does every command offered here parse as words the game knows? */
+	int ids[VALID_IDS];
+	size_t n = valid_actions(ids, VALID_IDS);
+
+	for (size_t i = 0; i < n; i++) {
+		char line[LINESIZE];
+		command_t cmd;
+		if (!valid_command(ids[i], line, sizeof(line))) {
+			return false;
+		}
+		tokenize(line, &cmd);
+		if (cmd.word[0].id == WORD_NOT_FOUND ||
+		    cmd.word[1].id == WORD_NOT_FOUND) {
+			return false;
+		}
+	}
+	return true;
+}
+
+char *myreadline(const char *prompt) {
+	/* Read the next line of the current test's input.  Mimics main.c:
+	 * script files are echoed here, standard input is not, and
+	 * running dry on standard input shows the prompt. */
+	current->prompts++;
+	if (game_observation != NULL && current->drift == 0) {
+		int32_t fresh[OBS_SIZE];
+		observe_full(fresh);
+		if (memcmp(fresh, game_observation, sizeof(fresh)) != 0) {
+			current->drift = current->prompts;
+		}
+	}
+	if (silentcheck) {
+		note_state();
+	}
+	if (validcheck && current->unparsed == 0 && !all_parse()) {
+		current->unparsed = current->prompts;
+	}
+	while (cursource < current->nsources) {
+		struct source_t *s = &current->source[cursource];
+		if (s->pos >= s->len) {
+			cursource++;
+			continue;
+		}
+		const char *line = s->text + s->pos;
+		const char *nl = memchr(line, '\n', s->len - s->pos);
+		size_t len = nl ? (size_t)(nl - line) + 1 : s->len - s->pos;
+		if (current->scripted && len > LINESIZE - 1) {
+			len = LINESIZE - 1; // fgets() would split it too
+		}
+		s->pos += len;
+		if (current->scripted) {
+			if (!settings.silent) {
+				fputs(prompt, settings.outfp);
+				fwrite(line, 1, len, settings.outfp);
+			}
+		} else if (nl != NULL && len > 0) {
+			len--; // readline() drops the newline
+		}
+		char *ln = malloc(len + 1);
+		memcpy(ln, line, len);
+		ln[len] = '\0';
+		return ln;
+	}
+	if (!current->scripted && !settings.silent) {
+		fputs(prompt, settings.outfp);
+	}
+	return NULL;
+}
+
+static void run_game(FILE *rfp) {
+	/* Play as main() does, until the game ends or input runs out. */
+	jmp_buf done;
+
+	settings.exitjmp = &done;
+	if (setjmp(done) == 0) {
+		int seedval = initialise();
+		if (!settings.silent) {
+			current->seed = seedval;
+		} else {
+			// The seed is in every state hashed; take the spoken run's
+			seedval = current->seed;
+			set_seed(seedval);
+		}
+		if (rfp == NULL) {
+			bool novice = yes_or_no(arbitrary_messages[WELCOME_YOU],
+			                        arbitrary_messages[CAVE_NEARBY],
+			                        arbitrary_messages[NO_MESSAGE]);
+			ZSET(game.novice, novice);
+			if (game.novice) {
+				ZSET(game.limit, NOVICELIMIT);
+			}
+		} else {
+			restore(rfp);
+		}
+		if (settings.logfp) {
+			fprintf(settings.logfp, "seed %d\n", seedval);
+		}
+		for (;;) {
+			if (!do_move()) {
+				continue;
+			}
+			if (!do_command()) {
+				break;
+			}
+		}
+		terminate(quitgame);
+	}
+}
+
+static void play(struct test_t *t, bool text, bool silent) {
+	/* Run one test's game to completion, capturing its transcript if
+	 * text is set and its hash records if hashing; a silent run only
+	 * checks its states against the last spoken one. */
+	FILE *rfp = NULL;
+	FILE *outfp = NULL, *records = NULL;
+	struct transcript_t transcript;
+	int32_t observation[OBS_SIZE];
+
+	memset(&settings, 0, sizeof(settings));
+	settings.prompt = true;
+	settings.silent = silent;
+	memset(&save, 0, sizeof(save));
+	reset_command();
+	for (int i = 0; i < t->nsources; i++) {
+		t->source[i].pos = 0;
+	}
+	current = t;
+	cursource = 0;
+	t->prompts = t->strayed = 0;
+	if (!silent) {
+		t->drift = t->nstates = t->unparsed = 0;
+	}
+	observe_attach(observecheck && !silent ? observation : NULL);
+
+	if (!silent) {
+		free(t->output);
+		free(t->records);
+		t->output = t->records = NULL;
+		t->outputlen = t->recordslen = 0;
+	}
+	if (text && (outfp = open_memstream(&t->output, &t->outputlen)) == NULL) {
+		return; // LCOV_EXCL_LINE
+	}
+	settings.outfp = outfp;
+	if ((hashcheck || hashwrite) && !silent) {
+		records = open_memstream(&t->records, &t->recordslen);
+		if (records == NULL ||
+		    transcript_open(&transcript, outfp, records) == NULL) {
+			// LCOV_EXCL_START
+			if (records != NULL) {
+				fclose(records);
+			}
+			if (outfp != NULL) {
+				fclose(outfp);
+			}
+			return;
+			// LCOV_EXCL_STOP
+		}
+		settings.outfp = transcript.stream;
+		settings.transcript = &transcript;
+	}
+
+	/* Same options as advent; anything else is ignored */
+	char *options = t->options ? strdup(t->options) : NULL;
+	char *save_ptr = NULL;
+	for (char *opt = options ? strtok_r(options, " \t", &save_ptr) : NULL;
+	     opt != NULL; opt = strtok_r(NULL, " \t", &save_ptr)) {
+		if (strcmp(opt, "-o") == 0) {
+			settings.oldstyle = true;
+			settings.prompt = false;
+		} else if (strcmp(opt, "-r") == 0 || strcmp(opt, "-l") == 0) {
+			char *arg = strtok_r(NULL, " \t", &save_ptr);
+			if (arg == NULL) {
+				break;
+			}
+			if (opt[1] == 'l') {
+				settings.logfp = fopen(arg, "w");
+			} else if ((rfp = fopen(arg, "r")) == NULL) {
+				fprintf(stderr,
+				        "advent: can't open save file %s for "
+				        "read\n",
+				        arg);
+			}
+		}
+	}
+	free(options);
+
+	run_game(rfp);
+	observe_attach(NULL);
+	if (silentcheck) {
+		t->prompts++; // the state the game ended in
+		note_state();
+		if (silent && t->prompts != t->nstates && t->strayed == 0) {
+			t->strayed = t->prompts;
+		}
+	}
+
+	if (settings.logfp != NULL) {
+		fclose(settings.logfp);
+	}
+	if (records != NULL) {
+		fclose(settings.outfp);
+		fclose(records);
+	}
+	if (outfp != NULL) {
+		fclose(outfp);
+	}
+	if (silent) {
+		return;
+	}
+	t->ok = t->expect != NULL && t->outputlen == t->expectlen &&
+	        memcmp(t->output, t->expect, t->expectlen) == 0 &&
+	        t->drift == 0 && t->unparsed == 0;
+}
+
+static bool same_hashes(const struct test_t *t) {
+	return t->hashes != NULL && t->records != NULL &&
+	       t->recordslen == t->hasheslen &&
+	       memcmp(t->records, t->hashes, t->hasheslen) == 0;
+}
+
+static void check(struct test_t *t) {
+	/* Decide one test, by hashes alone if they allow it. */
+	if (t->hashes != NULL) {
+		play(t, false, false);
+		t->ok = same_hashes(t) && t->drift == 0 && t->unparsed == 0;
+	}
+	if (!t->ok) {
+		play(t, true, false);
+		if (hashwrite && t->ok) {
+			char name[FILENAME_MAX];
+			snprintf(name, sizeof(name), "%s.hash", t->name);
+			FILE *fp = fopen(name, "w");
+			if (fp == NULL || fwrite(t->records, 1, t->recordslen,
+			                         fp) != t->recordslen) {
+				perror(name); // LCOV_EXCL_LINE
+			}
+			if (fp != NULL) {
+				fclose(fp);
+			}
+		}
+	}
+	if (silentcheck) {
+		play(t, false, true);
+		t->ok = t->ok && t->strayed == 0;
+	}
+}
+
+static void *worker(void *arg) {
+	/* Take chains off the list until there are none left. */
+	(void)arg;
+	for (;;) {
+		pthread_mutex_lock(&chainlock);
+		while (nextchain < ntests && tests[nextchain].chain != nextchain) {
+			nextchain++;
+		}
+		int chain = nextchain++;
+		pthread_mutex_unlock(&chainlock);
+		if (chain >= ntests) {
+			return NULL;
+		}
+		for (int i = chain; i < ntests && tests[i].chain == chain; i++) {
+			check(&tests[i]);
+		}
+	}
+}
+
+static void show_divergence(const struct test_t *t) {
+	/* Name the first hash record where this run left the expected
+	 * one, so the text diff can be read from there. */
+	const char *a = t->hashes, *b = t->records;
+	const char *aend = a + t->hasheslen, *bend = b + t->recordslen;
+
+	while (a < aend && b < bend) {
+		const char *anl = memchr(a, '\n', aend - a);
+		const char *bnl = memchr(b, '\n', bend - b);
+		size_t alen = anl ? (size_t)(anl - a) + 1 : (size_t)(aend - a);
+		size_t blen = bnl ? (size_t)(bnl - b) + 1 : (size_t)(bend - b);
+		if (alen != blen || memcmp(a, b, alen) != 0) {
+			break;
+		}
+		a += alen;
+		b += blen;
+	}
+	int prompt, turns;
+	uint64_t offset;
+	if (b < bend && sscanf(b, "%d %d %" SCNu64, &prompt, &turns,
+	                       &offset) == 3) {
+		printf("  # hashes diverge at prompt %d, turn %d, output byte "
+		       "%" PRIu64 "\n",
+		       prompt, turns, offset);
+	} else {
+		printf("  # hashes diverge after the last prompt\n");
+	}
+}
+
+static int count_lines(const char *text, size_t len, const char **line,
+                       int max) {
+	/* Index the starts of lines; line[n] is one past the end. */
+	int n = 0;
+	for (size_t i = 0; i < len && n < max; n++) {
+		line[n] = text + i;
+		const char *nl = memchr(text + i, '\n', len - i);
+		i = nl ? (size_t)(nl - text) + 1 : len;
+	}
+	line[n] = text + len;
+	return n;
+}
+
+static void show_line(char mark, const char *from, const char *to) {
+	size_t len = to - from;
+	if (len > 0 && from[len - 1] == '\n') {
+		len--;
+	}
+	printf("  %c%.*s\n", mark, (int)len, from);
+}
+
+static void show_diff(const struct test_t *t) {
+	/* A unified diff with a single hunk around the changed region. */
+	enum { CONTEXT = 3 };
+	int max = 1;
+	for (size_t i = 0; i < t->expectlen; i++) {
+		max += t->expect[i] == '\n';
+	}
+	for (size_t i = 0; i < t->outputlen; i++) {
+		max += t->output[i] == '\n';
+	}
+	const char **a = malloc((max + 1) * sizeof(char *));
+	const char **b = malloc((max + 1) * sizeof(char *));
+	int na = count_lines(t->expect, t->expectlen, a, max);
+	int nb = count_lines(t->output, t->outputlen, b, max);
+
+#define SAME(i, j) (a[(i) + 1] - a[i] == b[(j) + 1] - b[j] &&                   \
+	            memcmp(a[i], b[j], a[(i) + 1] - a[i]) == 0)
+	int head = 0, tail = 0;
+	while (head < na && head < nb && SAME(head, head)) {
+		head++;
+	}
+	while (tail < na - head && tail < nb - head &&
+	       SAME(na - 1 - tail, nb - 1 - tail)) {
+		tail++;
+	}
+#undef SAME
+	int from = head > CONTEXT ? head - CONTEXT : 0;
+	int after = tail > CONTEXT ? CONTEXT : tail;
+
+	printf("  --- |\n  --- %s.chk\n  +++ %s\n", t->name, t->name);
+	printf("  @@ -%d,%d +%d,%d @@\n", from + 1, na - tail + after - from,
+	       from + 1, nb - tail + after - from);
+	for (int i = from; i < head; i++) {
+		show_line(' ', a[i], a[i + 1]);
+	}
+	for (int i = head; i < na - tail; i++) {
+		show_line('-', a[i], a[i + 1]);
+	}
+	for (int i = head; i < nb - tail; i++) {
+		show_line('+', b[i], b[i + 1]);
+	}
+	for (int i = na - tail; i < na - tail + after; i++) {
+		show_line(' ', a[i], a[i + 1]);
+	}
+	printf("  ...\n");
+	free(a);
+	free(b);
+}
+
+int main(int argc, char *argv[]) {
+	int ch;
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	bool plan = true;
+	bool quiet = getenv("QUIET") != NULL && strcmp(getenv("QUIET"), "1") == 0;
+	const char *usage =
+	    "Usage: %s [-j jobs] [-n] [-H] [-w] [-O] [-S] [-V] [-C directory] [log...]\n"
+	    "        -j number of games to run at once\n"
+	    "        -n omit the TAP plan line\n"
+	    "        -H trust matching stem.hash records over a text diff\n"
+	    "        -w write stem.hash for every passing test\n"
+	    "        -O check incremental observations at every prompt\n"
+	    "        -S check that silent play matches at every prompt\n"
+	    "        -V check that every valid action parses at every prompt\n"
+	    "        -C run in the given test directory\n";
+
+	while ((ch = getopt(argc, argv, "j:nHwOSVC:")) != EOF) {
+		switch (ch) {
+		case 'H':
+			hashcheck = true;
+			break;
+		case 'w':
+			hashwrite = true;
+			break;
+		case 'O':
+			observecheck = true;
+			break;
+		case 'S':
+			silentcheck = true;
+			break;
+		case 'V':
+			validcheck = true;
+			break;
+		case 'j':
+			jobs = atol(optarg);
+			break;
+		case 'n':
+			plan = false;
+			break;
+		case 'C':
+			if (chdir(optarg) != 0) {
+				perror(optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		default:
+			fprintf(stderr, usage, argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+
+	glob_t logs = {0};
+	if (optind < argc) {
+		for (int i = optind; i < argc; i++) {
+			glob(argv[i], GLOB_NOCHECK | (i > optind ? GLOB_APPEND : 0),
+			     NULL, &logs);
+		}
+	} else {
+		glob("*.log", 0, NULL, &logs);
+	}
+	size_t nmulti = optind < argc ? 0 : sizeof(multifiles) / sizeof(multifiles[0]);
+	tests = calloc(logs.gl_pathc + nmulti, sizeof(struct test_t));
+	for (size_t i = 0; i < logs.gl_pathc; i++) {
+		if (!add_log(logs.gl_pathv[i])) {
+			exit(EXIT_FAILURE);
+		}
+	}
+	chain_tests();
+	for (size_t i = 0; i < nmulti; i++) {
+		add_multifile(i);
+	}
+	globfree(&logs);
+
+	pthread_t *pool = calloc(jobs, sizeof(pthread_t));
+	for (long i = 0; i < jobs; i++) {
+		pthread_create(&pool[i], NULL, worker, NULL);
+	}
+	for (long i = 0; i < jobs; i++) {
+		pthread_join(pool[i], NULL);
+	}
+	free(pool);
+
+	int failed = 0;
+	if (plan) {
+		printf("1..%d\n", ntests);
+	}
+	for (int i = 0; i < ntests; i++) {
+		struct test_t *t = &tests[i];
+		printf("%s - %s: %s\n", t->ok ? "ok" : "not ok", t->name,
+		       t->legend ? t->legend : "");
+		if (!t->ok) {
+			failed++;
+			if (t->expect == NULL) {
+				printf("  # no check file for %s\n", t->name);
+			} else if (t->drift != 0) {
+				printf("  # observation drifted by prompt %d\n",
+				       t->drift);
+			} else if (t->strayed != 0) {
+				printf("  # silent play strayed by prompt %d\n",
+				       t->strayed);
+			} else if (t->unparsed != 0) {
+				printf("  # a valid action failed to parse at prompt %d\n",
+				       t->unparsed);
+			} else if (!quiet) {
+				if (t->hashes != NULL) {
+					show_divergence(t);
+				}
+				show_diff(t);
+			}
+		}
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* end */
@@ -0,0 +1,53 @@
+/*
+ * 'rngdump' prints a random-draw trace written by advent -d as text,
+ * one draw per line: draw number, turn, call site, range, result and
+ * the raw LCG value.  Two traces of what should be the same game can
+ * be diffed to find the first draw where they part.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[]) {
+	int ch;
+	FILE *in = stdin, *out = stdout;
+	const char *usage = "Usage: %s [-o textfile] [tracefile]\n";
+
+	while ((ch = getopt(argc, argv, "o:")) != EOF) {
+		switch (ch) {
+		case 'o':
+			out = fopen(optarg, "w");
+			if (out == NULL) {
+				fprintf(stderr, "Can't open file %s. Exiting.\n",
+				        optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		default:
+			fprintf(stderr, usage, argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (optind < argc) {
+		in = fopen(argv[optind], READ_MODE);
+		if (in == NULL) {
+			fprintf(stderr, "Can't open file %s. Exiting.\n",
+			        argv[optind]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (rngtrace_decode(in, out) < 0) {
+		fprintf(stderr, "rngdump: malformed trace\n");
+		exit(EXIT_FAILURE);
+	}
+
+	fclose(out);
+	return EXIT_SUCCESS;
+}
+
+/* end */
@@ -0,0 +1,169 @@
+/*
+ * Ring buffer of random draws, kept by advent -d.
+ *
+ * Every randrange() call (PCT() included) notes its call site, turn,
+ * range and the LCG value it consumed in a fixed ring of the last
+ * RNGTRACE_SIZE draws; see randrange_at() in misc.c.  Recording is a
+ * few stores; nothing is formatted or written until the ring is saved.
+ *
+ * Saved traces are binary, in native byte order like save files:
+ *
+ *	magic "advent-rngtrace\n"
+ *	uint64 draws ever recorded
+ *	uint32 records that follow, oldest first
+ *	uint32 call sites, then each as uint32 length and the name
+ *	each record: int32 site index, line, turn, range, value
+ *
+ * rngtrace_save() uses only write(2), so a host may call it from a
+ * signal handler.  rngdump turns a saved trace back into text.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "advent.h"
+
+#define RNGTRACE_MAGIC "advent-rngtrace\n"
+#define RNGTRACE_SITES 256 // distinct call sites a trace can name
+
+/* Buffered write(2), safe in a signal handler */
+struct out_t {
+	int fd;
+	size_t len;
+	bool failed;
+	unsigned char buf[4096];
+};
+
+static void out_flush(struct out_t *out) {
+	if (out->len > 0 && write(out->fd, out->buf, out->len) < 0) {
+		out->failed = true; // LCOV_EXCL_LINE
+	}
+	out->len = 0;
+}
+
+static void out_bytes(struct out_t *out, const void *data, size_t n) {
+	if (out->len + n > sizeof(out->buf)) {
+		out_flush(out);
+	}
+	memcpy(out->buf + out->len, data, n);
+	out->len += n;
+}
+
+static void out_int32(struct out_t *out, int32_t val) {
+	out_bytes(out, &val, sizeof(val));
+}
+
+bool rngtrace_save(const struct rngtrace_t *trace, int fd) {
+	/* Write the ring to fd, oldest draw first. */
+	struct out_t out = {.fd = fd};
+	const char *sites[RNGTRACE_SITES];
+	uint32_t nsites = 0;
+	uint32_t count =
+	    trace->draws < RNGTRACE_SIZE ? trace->draws : RNGTRACE_SIZE;
+	uint64_t first = trace->draws - count;
+
+	/* Call sites are string literals; intern them by address */
+	for (uint64_t i = first; i < trace->draws; i++) {
+		const char *func = trace->ring[i & (RNGTRACE_SIZE - 1)].func;
+		uint32_t s = 0;
+		while (s < nsites && sites[s] != func) {
+			s++;
+		}
+		if (s == nsites && nsites < RNGTRACE_SITES) {
+			sites[nsites++] = func;
+		}
+	}
+
+	out_bytes(&out, RNGTRACE_MAGIC, sizeof(RNGTRACE_MAGIC) - 1);
+	out_bytes(&out, &trace->draws, sizeof(trace->draws));
+	out_bytes(&out, &count, sizeof(count));
+	out_bytes(&out, &nsites, sizeof(nsites));
+	for (uint32_t s = 0; s < nsites; s++) {
+		uint32_t len = strlen(sites[s]);
+		out_bytes(&out, &len, sizeof(len));
+		out_bytes(&out, sites[s], len);
+	}
+	for (uint64_t i = first; i < trace->draws; i++) {
+		const struct rngdraw_t *draw =
+		    &trace->ring[i & (RNGTRACE_SIZE - 1)];
+		int32_t s = 0;
+		while ((uint32_t)s < nsites && sites[s] != draw->func) {
+			s++;
+		}
+		out_int32(&out, (uint32_t)s < nsites ? s : -1);
+		out_int32(&out, draw->line);
+		out_int32(&out, draw->turn);
+		out_int32(&out, draw->range);
+		out_int32(&out, draw->value);
+	}
+	out_flush(&out);
+	return !out.failed;
+}
+
+/* Decoding */
+
+int rngtrace_decode(FILE *in, FILE *out) {
+	/* Print a saved trace as text, one draw per line.  Returns the
+	 * number of draws printed, or -1 if the trace is malformed. */
+	char magic[sizeof(RNGTRACE_MAGIC) - 1];
+	uint64_t draws;
+	uint32_t count, nsites;
+
+	if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+	    memcmp(magic, RNGTRACE_MAGIC, sizeof(magic)) != 0 ||
+	    fread(&draws, sizeof(draws), 1, in) != 1 ||
+	    fread(&count, sizeof(count), 1, in) != 1 ||
+	    fread(&nsites, sizeof(nsites), 1, in) != 1 ||
+	    nsites > RNGTRACE_SITES || count > draws) {
+		return -1;
+	}
+
+	char *sites[RNGTRACE_SITES];
+	int result = 0;
+	for (uint32_t s = 0; s < nsites; s++) {
+		uint32_t len;
+		if (fread(&len, sizeof(len), 1, in) != 1 || len > LINESIZE) {
+			nsites = s;
+			result = -1;
+			break;
+		}
+		sites[s] = calloc(len + 1, 1);
+		if (fread(sites[s], 1, len, in) != len) {
+			nsites = s + 1;
+			result = -1;
+			break;
+		}
+	}
+
+	if (result == 0) {
+		fprintf(out, "%-8s %6s %-24s %6s %8s %s\n", "draw", "turn",
+		        "site", "range", "result", "lcg");
+	}
+	for (uint32_t i = 0; result >= 0 && i < count; i++) {
+		int32_t rec[5];
+		if (fread(rec, sizeof(int32_t), 5, in) != 5) {
+			result = -1;
+			break;
+		}
+		char site[LINESIZE + 16];
+		snprintf(site, sizeof(site), "%s:%d",
+		         rec[0] >= 0 && (uint32_t)rec[0] < nsites ? sites[rec[0]]
+		                                                  : "?",
+		         rec[1]);
+		fprintf(out, "%-8" PRIu64 " %6d %-24s %6d %8d %d\n",
+		        draws - count + i, rec[2], site, rec[3],
+		        (int32_t)((int64_t)rec[3] * rec[4] / LCG_M), rec[4]);
+		result++;
+	}
+	for (uint32_t s = 0; s < nsites; s++) {
+		free(sites[s]);
+	}
+	return result;
+}
+
+/* end */
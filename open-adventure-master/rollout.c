@@ -0,0 +1,262 @@
+/*
+ * Monte-Carlo rollouts: what each command worth trying next is likely
+ * to be worth, for hints and for judging bots.
+ *
+ * rollout_evaluate() lists the candidates with valid_actions() and, for
+ * each, plays it and then a policy's choices for a number of commands
+ * more, many times over, on a pool of threads.  Every rollout starts
+ * from a plain struct copy of the given game, played silently in the
+ * thread's own game; the caller's game is only read.  At the end the
+ * score is taken as the score command would give it, and whether the
+ * player died along the way.
+ *
+ * Rollout k of every candidate runs the game's generator k *
+ * ROLLOUT_STRIDE draws ahead of the position it was copied at, and gives
+ * the policy the same random numbers, so candidates are compared under
+ * the same luck; rollout 0 sees the draws the game would really make.
+ * Rollouts are handed out round-robin over the candidates, so when the
+ * budget runs out they all have (nearly) the same number.  Without a
+ * budget, the values depend only on the game, the candidates and the
+ * seed, not on the number of threads.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "advent.h"
+
+#define ROLLOUT_STRIDE 7919 // draws between one rollout's luck and the next
+#define MAXCHOICES 512      // valid commands looked at per prompt
+
+/* One call's work, shared by its threads */
+struct shared_t {
+	const struct game_t *from;
+	const struct rollout_t *how;
+	struct rollout_value_t *values;
+	size_t n;        // candidates
+	long total;      // rollouts to run
+	long next;       // the next one to start
+	double deadline; // CLOCK_MONOTONIC seconds, or 0
+	pthread_mutex_t lock;
+};
+
+/* The rollout a thread is playing; rollout_readline() feeds it */
+static THREAD_LOCAL struct {
+	const struct rollout_t *how;
+	const char *first; // the candidate, until it has been played
+	int left;          // commands still to play
+	uint32_t rng;
+} walk;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t xorshift(uint32_t *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static char *rollout_readline(const char *prompt) {
+	/* The candidate, then the policy's picks, until the horizon. */
+	char line[LINESIZE];
+	int ids[MAXCHOICES];
+
+	(void)prompt;
+	if (walk.left-- <= 0) {
+		return NULL;
+	}
+	if (walk.first != NULL) {
+		snprintf(line, sizeof(line), "%s", walk.first);
+		walk.first = NULL;
+	} else {
+		size_t n = valid_actions(ids, MAXCHOICES);
+		size_t pick;
+		if (n > MAXCHOICES) {
+			n = MAXCHOICES; // LCOV_EXCL_LINE
+		}
+		if (walk.how->policy != NULL) {
+			pick = walk.how->policy(ids, n, &walk.rng,
+			                        walk.how->context);
+		} else {
+			pick = xorshift(&walk.rng) % n;
+		}
+		if (pick >= n || !valid_command(ids[pick], line, sizeof(line))) {
+			return NULL;
+		}
+	}
+	return strdup(line);
+}
+
+static bool rollout_answer(const char *question) {
+	/* Yes only to the question asked silently, the dragon's. */
+	return question == NULL;
+}
+
+static int points(void) {
+	/* The score as it stands, as the score command reckons it */
+	int total = score_standing();
+	for (obj_t i = 1; i <= NOBJECTS; i++) {
+		total += score_object(i);
+	}
+	return total;
+}
+
+static void rollout(const struct shared_t *sh, size_t c, long k, int *score,
+                    bool *survived) {
+	/* Play candidate c's rollout k to the horizon or the game's end. */
+	char first[LINESIZE];
+	jmp_buf over;
+
+	walk.how = sh->how;
+	walk.first = first;
+	walk.left = sh->how->horizon + 1;
+	walk.rng = (sh->how->seed ^ 0x9e3779b9u) * 2654435761u + (uint32_t)k;
+	if (walk.rng == 0) {
+		walk.rng = 1; // LCOV_EXCL_LINE
+	}
+	for (int i = 0; i < 4; i++) {
+		xorshift(&walk.rng);
+	}
+	settings.exitjmp = &over;
+	if (setjmp(over) == 0) {
+		game = *sh->from;
+		// Spelled in this game, which knows its own magic word
+		valid_command(sh->values[c].id, first, sizeof(first));
+		zobrist_rehash();
+		await_command();
+		rng_skip((uint64_t)k * ROLLOUT_STRIDE);
+		/* The main() loop, entered at the prompt */
+		for (bool moving = false;; moving = true) {
+			if (moving && !do_move()) {
+				continue;
+			}
+			if (!do_command()) {
+				break;
+			}
+		}
+	}
+	settings.exitjmp = NULL;
+	*score = points();
+	*survived = game.numdie == sh->from->numdie;
+}
+
+static void *worker(void *arg) {
+	/* Take rollouts until there are none left or time is up, then add
+	 * what they came to into the shared values. */
+	struct shared_t *sh = arg;
+	double *score = calloc(sh->n, sizeof(double));
+	double *survived = calloc(sh->n, sizeof(double));
+	int *runs = calloc(sh->n, sizeof(int));
+
+	memset(&settings, 0, sizeof(settings));
+	settings.silent = true;
+	settings.answer = rollout_answer;
+	settings.readline = rollout_readline;
+	for (;;) {
+		long w = __atomic_fetch_add(&sh->next, 1, __ATOMIC_RELAXED);
+		if (w >= sh->total || (sh->deadline > 0 && now() > sh->deadline)) {
+			break;
+		}
+		size_t c = w % sh->n;
+		int got;
+		bool lived;
+		rollout(sh, c, w / sh->n, &got, &lived);
+		score[c] += got;
+		survived[c] += lived;
+		runs[c]++;
+	}
+
+	pthread_mutex_lock(&sh->lock);
+	for (size_t c = 0; c < sh->n; c++) {
+		sh->values[c].score += score[c];
+		sh->values[c].survival += survived[c];
+		sh->values[c].runs += runs[c];
+	}
+	pthread_mutex_unlock(&sh->lock);
+	free(score);
+	free(survived);
+	free(runs);
+	return NULL;
+}
+
+static size_t candidates(const struct game_t *from, int *ids, size_t max) {
+	/* valid_actions() for a game that need not be the live one.  It
+	 * is swapped in by plain copies, with no ZSET(), so the live
+	 * game's hash and observation are left as they were. */
+	size_t n;
+
+	if (from == &game) {
+		return valid_actions(ids, max);
+	}
+	struct game_t *live = malloc(sizeof(struct game_t));
+	if (live == NULL) {
+		return 0; // LCOV_EXCL_LINE
+	}
+	*live = game;
+	game = *from;
+	n = valid_actions(ids, max);
+	game = *live;
+	free(live);
+	return n;
+}
+
+size_t rollout_evaluate(const struct game_t *from, const struct rollout_t *how,
+                        struct rollout_value_t *values, size_t max) {
+	/* Value up to max candidate commands from the game at the command
+	 * prompt in from; return how many were valued. */
+	int ids[MAXCHOICES];
+	struct shared_t sh = {.from = from, .how = how, .values = values};
+	int jobs = how->jobs < 1 ? 1 : how->jobs;
+
+	sh.n = candidates(from, ids, MAXCHOICES);
+	if (sh.n > max) {
+		sh.n = max;
+	}
+	if (sh.n > MAXCHOICES) {
+		sh.n = MAXCHOICES; // LCOV_EXCL_LINE
+	}
+	if (sh.n == 0) {
+		return 0;
+	}
+	for (size_t c = 0; c < sh.n; c++) {
+		values[c] = (struct rollout_value_t){.id = ids[c]};
+	}
+	sh.total = (long)sh.n * (how->rollouts < 1 ? 1 : how->rollouts);
+	if (how->budget > 0) {
+		sh.deadline = now() + how->budget / 1000.0;
+	}
+	pthread_mutex_init(&sh.lock, NULL);
+
+	/* Rollouts always run on threads of their own, since each plays
+	 * in its thread's game and the caller's must be left alone. */
+	pthread_t *pool = calloc(jobs, sizeof(pthread_t));
+	for (int i = 0; i < jobs; i++) {
+		pthread_create(&pool[i], NULL, worker, &sh);
+	}
+	for (int i = 0; i < jobs; i++) {
+		pthread_join(pool[i], NULL);
+	}
+	free(pool);
+	pthread_mutex_destroy(&sh.lock);
+
+	for (size_t c = 0; c < sh.n; c++) {
+		if (values[c].runs > 0) {
+			values[c].score /= values[c].runs;
+			values[c].survival /= values[c].runs;
+		}
+	}
+	return sh.n;
+}
+
+/* end */
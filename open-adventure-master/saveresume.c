@@ -21,7 +21,56 @@
  */
 #define ENDIAN_MAGIC 2317
 
-struct save_t save;
+THREAD_LOCAL struct save_t save;
+
+/* Scalars shared by struct game_t and its save layout */
+#define GAME_SCALARS(X)                                                        \
+	X(lcg_x) X(abbnum) X(bonus) X(chloc) X(chloc2) X(clock1) X(clock2)     \
+	X(clshnt) X(closed) X(closng) X(lmwarn) X(novice) X(panic) X(wzdark)   \
+	X(blooded) X(conds) X(detail) X(dflag) X(dkill) X(dtotal) X(foobar)    \
+	X(holdng) X(igo) X(iwest) X(knfloc) X(limit) X(loc) X(newloc)          \
+	X(numdie) X(oldloc) X(oldlc2) X(oldobj) X(saved) X(tally) X(thresh)    \
+	X(seenbigwords) X(trnluz) X(turns)
+
+#define COPY_FIELD(f) to->f = from->f;
+
+/* Every field, copied from *from to *to; one list for both directions */
+#define COPY_GAME()                                                            \
+	do {                                                                   \
+		GAME_SCALARS(COPY_FIELD)                                       \
+		memcpy(to->zzword, from->zzword, sizeof(to->zzword));          \
+		for (int i = 0; i <= NLOCATIONS; i++) {                        \
+			COPY_FIELD(locs[i].abbrev)                             \
+			COPY_FIELD(locs[i].atloc)                              \
+		}                                                              \
+		for (int i = 0; i <= NDWARVES; i++) {                          \
+			COPY_FIELD(dwarves[i].seen)                            \
+			COPY_FIELD(dwarves[i].loc)                             \
+			COPY_FIELD(dwarves[i].oldloc)                          \
+		}                                                              \
+		for (int i = 0; i <= NOBJECTS; i++) {                          \
+			COPY_FIELD(objects[i].fixed)                           \
+			COPY_FIELD(objects[i].prop)                            \
+			COPY_FIELD(objects[i].place)                           \
+		}                                                              \
+		for (int i = 0; i < NHINTS; i++) {                             \
+			COPY_FIELD(hints[i].used)                              \
+			COPY_FIELD(hints[i].lc)                                \
+		}                                                              \
+		for (int i = 0; i <= NOBJECTS * 2; i++) {                      \
+			COPY_FIELD(link[i])                                    \
+		}                                                              \
+	} while (0)
+
+static void pack_game(struct savegame_t *to, const struct game_t *from) {
+	/* Widen the live game into the save layout. */
+	COPY_GAME();
+}
+
+static void unpack_game(struct game_t *to, const struct savegame_t *from) {
+	/* Narrow a validated save back into the live game. */
+	COPY_GAME();
+}
 
 #define IGNORE(r)                                                              \
 	do {                                                                   \
@@ -38,7 +87,8 @@ int savefile(FILE *fp) {
 	if (save.canary == 0) {
 		save.canary = ENDIAN_MAGIC;
 	}
-	save.game = game;
+	pack_game(&save.game, &game);
+	PROBE(save, game.turns);
 	IGNORE(fwrite(&save, sizeof(struct save_t), 1, fp));
 	return (0);
 }
@@ -68,12 +118,17 @@ int suspend(void) {
 	/*  Suspend.  Offer to save things in a file, but charging
 	 *  some points (so can't win by using saved games to retry
 	 *  battles or to start over after learning zzword).
-	 *  If ADVENT_NOSAVE is defined, gripe instead. */
+	 *  If ADVENT_NOSAVE is defined or settings.nosave set, gripe
+	 *  instead. */
 
 #if defined ADVENT_NOSAVE || defined ADVENT_AUTOSAVE
 	rspeak(SAVERESUME_DISABLED);
 	return GO_TOP;
 #endif
+	if (settings.nosave) {
+		rspeak(SAVERESUME_DISABLED);
+		return GO_TOP;
+	}
 	FILE *fp = NULL;
 
 	rspeak(SUSPEND_WARNING);
@@ -82,38 +137,45 @@ int suspend(void) {
 	               arbitrary_messages[OK_MAN])) {
 		return GO_CLEAROBJ;
 	}
-	game.saved = game.saved + 5;
+	ZSET(game.saved, game.saved + 5);
 
 	while (fp == NULL) {
-		char *name = myreadline("\nFile name: ");
-		if (name == NULL) {
+		char *line = myreadline("\nFile name: ");
+		if (line == NULL) {
 			return GO_TOP;
 		}
-		name = strip(name);
+		char *name = strip(line);
 		if (strlen(name) == 0) {
+			free(line);    // LCOV_EXCL_LINE
 			return GO_TOP; // LCOV_EXCL_LINE
 		}
 		fp = fopen(strip(name), WRITE_MODE);
-		if (fp == NULL) {
-			printf("Can't open file %s, try again.\n", name);
+		if (fp == NULL && !settings.silent) {
+			fprintf(settings.outfp,
+			        "Can't open file %s, try again.\n", name);
 		}
-		free(name);
+		free(line);
 	}
 
 	savefile(fp);
 	fclose(fp);
 	rspeak(RESUME_HELP);
-	exit(EXIT_SUCCESS);
+	session_exit(EXIT_SUCCESS);
 }
 
 int resume(void) {
 	/*  Resume.  Read a suspended game back from a file.
-	 *  If ADVENT_NOSAVE is defined, gripe instead. */
+	 *  If ADVENT_NOSAVE is defined or settings.nosave set, gripe
+	 *  instead. */
 
 #if defined ADVENT_NOSAVE || defined ADVENT_AUTOSAVE
 	rspeak(SAVERESUME_DISABLED);
 	return GO_TOP;
 #endif
+	if (settings.nosave) {
+		rspeak(SAVERESUME_DISABLED);
+		return GO_TOP;
+	}
 	FILE *fp = NULL;
 
 	if (game.loc != LOC_START || game.locs[LOC_START].abbrev != 1) {
@@ -126,19 +188,21 @@ int resume(void) {
 	}
 
 	while (fp == NULL) {
-		char *name = myreadline("\nFile name: ");
-		if (name == NULL) {
+		char *line = myreadline("\nFile name: ");
+		if (line == NULL) {
 			return GO_TOP;
 		}
-		name = strip(name);
+		char *name = strip(line);
 		if (strlen(name) == 0) {
+			free(line);    // LCOV_EXCL_LINE
 			return GO_TOP; // LCOV_EXCL_LINE
 		}
 		fp = fopen(name, READ_MODE);
-		if (fp == NULL) {
-			printf("Can't open file %s, try again.\n", name);
+		if (fp == NULL && !settings.silent) {
+			fprintf(settings.outfp,
+			        "Can't open file %s, try again.\n", name);
 		}
-		free(name);
+		free(line);
 	}
 
 	return restore(fp);
@@ -163,14 +227,19 @@ int restore(FILE *fp) {
 		       SAVE_VERSION / 10, MOD(SAVE_VERSION, 10));
 	} else if (!is_valid(save.game)) {
 		rspeak(SAVE_TAMPERING);
-		exit(EXIT_SUCCESS);
+		session_exit(EXIT_SUCCESS);
 	} else {
-		game = save.game;
+		unpack_game(&game, &save.game);
+		zobrist_rehash();
+		if (settings.transcript != NULL) {
+			settings.transcript->seeded = true;
+		}
+		PROBE(restore, game.turns);
 	}
 	return GO_TOP;
 }
 
-bool is_valid(struct game_t valgame) {
+bool is_valid(struct savegame_t valgame) {
 	/*  Save files can be roughly grouped into three groups:
 	 *  With valid, reachable state, with valid, but unreachable
 	 *  state and with invalid state. We check that state is
@@ -182,6 +251,25 @@ bool is_valid(struct game_t valgame) {
 		return false; // LCOV_EXCL_LINE
 	}
 
+	/* Reject values the compact in-memory layout cannot hold */
+	int32_t narrow[] = {valgame.abbnum, valgame.clock1, valgame.clock2,
+	                    valgame.dflag,  valgame.foobar, valgame.holdng,
+	                    valgame.knfloc, valgame.oldobj, valgame.thresh};
+	for (size_t i = 0; i < sizeof(narrow) / sizeof(narrow[0]); i++) {
+		if (narrow[i] < INT16_MIN || narrow[i] > INT16_MAX) {
+			return false; // LCOV_EXCL_LINE
+		}
+	}
+	if (valgame.bonus < none || valgame.bonus > victory) {
+		return false; // LCOV_EXCL_LINE
+	}
+	for (int i = 0; i <= NLOCATIONS; i++) {
+		if (valgame.locs[i].abbrev < 0 ||
+		    valgame.locs[i].abbrev > UINT16_MAX) {
+			return false; // LCOV_EXCL_LINE
+		}
+	}
+
 	/* Check for RNG overflow. Truncate */
 	if (valgame.lcg_x >= LCG_M) {
 		return false;
@@ -8,58 +8,42 @@
 #include "dungeon.h"
 #include <stdlib.h>
 
-static int mxscor; /* ugh..the price for having score() not exit. */
+static THREAD_LOCAL int mxscor; /* ugh..the price for having score() not exit. */
 
-int score(enum termination mode) {
-	/* mode is 'scoregame' if scoring, 'quitgame' if quitting, 'endgame' if
-	 * died or won */
+int score_object(obj_t i) {
+	/* The points object i is earning the player right now.  Treasures
+	 * must be in the building and not broken; give the poor guy 2
+	 * points just for finding each one. */
 	int score = 0;
 
-	/*  The present scoring algorithm is as follows:
-	 *     Objective:          Points:        Present total possible:
-	 *  Getting well into cave   25                    25
-	 *  Each treasure < chest    12                    60
-	 *  Treasure chest itself    14                    14
-	 *  Each treasure > chest    16                   224
-	 *  Surviving             (MAX-NUM)*10             30
-	 *  Not quitting              4                     4
-	 *  Reaching "game.closng"   25                    25
-	 *  "Closed": Quit/Killed    10
-	 *            Klutzed        25
-	 *            Wrong way      30
-	 *            Success        45                    45
-	 *  Came to Witt's End        1                     1
-	 *  Round out the total       2                     2
-	 *                                       TOTAL:   430
-	 *  Points can also be deducted for using hints or too many turns, or
-	 * for saving intermediate positions. */
-
-	/*  First tally up the treasures.  Must be in building and not broken.
-	 *  Give the poor guy 2 points just for finding each treasure. */
-	mxscor = 0;
-	for (int i = 1; i <= NOBJECTS; i++) {
-		if (!objects[i].is_treasure) {
-			continue;
+	if (objects[i].is_treasure && objects[i].inventory != 0) {
+		int k = 12;
+		if (i == CHEST) {
+			k = 14;
 		}
-		if (objects[i].inventory != 0) {
-			int k = 12;
-			if (i == CHEST) {
-				k = 14;
-			}
-			if (i > CHEST) {
-				k = 16;
-			}
-			if (!OBJECT_IS_STASHED(i) && !OBJECT_IS_NOTFOUND(i)) {
-				score += 2;
-			}
-			if (game.objects[i].place == LOC_BUILDING &&
-			    OBJECT_IS_FOUND(i)) {
-				score += k - 2;
-			}
-			mxscor += k;
+		if (i > CHEST) {
+			k = 16;
+		}
+		if (!OBJECT_IS_STASHED(i) && !OBJECT_IS_NOTFOUND(i)) {
+			score += 2;
+		}
+		if (game.objects[i].place == LOC_BUILDING && OBJECT_IS_FOUND(i)) {
+			score += k - 2;
 		}
 	}
 
+	/* Did he come to Witt's End as he should? */
+	if (i == MAGAZINE && game.objects[i].place == LOC_WITTSEND) {
+		score += 1;
+	}
+	return score;
+}
+
+int score_standing(void) {
+	/* The points not earned by objects, less deductions, as they stand.
+	 * Scoring them, like score_object(), says nothing to the player. */
+	int score = 0;
+
 	/*  Now look at how he finished and how far he got.  NDEATHS and
 	 *  game.numdie tell us how well he survived.  game.dflag will tell us
 	 *  if he ever got suitably deep into the cave.  game.closng still
@@ -67,19 +51,12 @@ int score(enum termination mode) {
 	 *  "cave closed" (indicated by "game.closed"), then bonus is zero for
 	 *  mundane exits or 133, 134, 135 if he blew it (so to speak). */
 	score += (NDEATHS - game.numdie) * 10;
-	mxscor += NDEATHS * 10;
-	if (mode == endgame) {
-		score += 4;
-	}
-	mxscor += 4;
 	if (game.dflag != 0) {
 		score += 25;
 	}
-	mxscor += 25;
 	if (game.closng) {
 		score += 25;
 	}
-	mxscor += 25;
 	if (game.closed) {
 		if (game.bonus == none) {
 			score += 10;
@@ -94,17 +71,9 @@ int score(enum termination mode) {
 			score += 45;
 		}
 	}
-	mxscor += 45;
-
-	/* Did he come to Witt's End as he should? */
-	if (game.objects[MAGAZINE].place == LOC_WITTSEND) {
-		score += 1;
-	}
-	mxscor += 1;
 
 	/* Round it off. */
 	score += 2;
-	mxscor += 2;
 
 	/* Deduct for hints/turns/saves. Hints < 4 are special; see database
 	 * desc. */
@@ -120,6 +89,43 @@ int score(enum termination mode) {
 		score -= 10;
 	}
 	score = score - game.trnluz - game.saved;
+	return score;
+}
+
+int score(enum termination mode) {
+	/* mode is 'scoregame' if scoring, 'quitgame' if quitting, 'endgame' if
+	 * died or won */
+	int score = score_standing();
+
+	/*  The present scoring algorithm is as follows:
+	 *     Objective:          Points:        Present total possible:
+	 *  Getting well into cave   25                    25
+	 *  Each treasure < chest    12                    60
+	 *  Treasure chest itself    14                    14
+	 *  Each treasure > chest    16                   224
+	 *  Surviving             (MAX-NUM)*10             30
+	 *  Not quitting              4                     4
+	 *  Reaching "game.closng"   25                    25
+	 *  "Closed": Quit/Killed    10
+	 *            Klutzed        25
+	 *            Wrong way      30
+	 *            Success        45                    45
+	 *  Came to Witt's End        1                     1
+	 *  Round out the total       2                     2
+	 *                                       TOTAL:   430
+	 *  Points can also be deducted for using hints or too many turns, or
+	 * for saving intermediate positions. */
+	mxscor = 0;
+	for (int i = 1; i <= NOBJECTS; i++) {
+		score += score_object(i);
+		if (objects[i].is_treasure && objects[i].inventory != 0) {
+			mxscor += i < CHEST ? 12 : i == CHEST ? 14 : 16;
+		}
+	}
+	if (mode == endgame) {
+		score += 4;
+	}
+	mxscor += NDEATHS * 10 + 4 + 25 + 25 + 45 + 1 + 2;
 
 	/* Return to score command if that's where we came from. */
 	if (mode == scoregame) {
@@ -152,11 +158,11 @@ void terminate(enum termination mode) {
 			} else {
 				rspeak(NO_HIGHER);
 			}
-			exit(EXIT_SUCCESS);
+			session_exit(EXIT_SUCCESS);
 		}
 	}
 	rspeak(OFF_SCALE);
-	exit(EXIT_SUCCESS);
+	session_exit(EXIT_SUCCESS);
 }
 
 /* end */
@@ -0,0 +1,492 @@
+/*
+ * 'advent-server' hosts many games in one process, one per connection
+ * on a TCP port or a Unix socket, for players behind a telnet-style
+ * gateway or plain netcat.
+ *
+ * Each thread runs an epoll reactor over the connections it accepted.
+ * A session keeps its game as a struct game_t between commands, with
+ * the command it was prompting within; when a line arrives the game is
+ * loaded into the thread's live game and played to the next prompt, as
+ * batch.c steps its games, and the output goes to the session's
+ * buffer.  Yes/no questions come through settings.answer: a question
+ * with no answer yet ends the step with the game as it was before it,
+ * and once the player answers, the step is played again from there
+ * with the answer, its output up to the question skipped.  The engine
+ * keeps all its randomness in the game, so the replay goes exactly as
+ * the first run did.
+ *
+ * Output is sent as the socket takes it.  A session with more than
+ * OUTHIGH bytes unsent has its input left unread, so a client that
+ * doesn't read holds up only itself.  Saving and restoring are refused
+ * through settings.nosave, before the points a save costs are taken,
+ * since the server would otherwise write files at a player's say-so;
+ * end of input ends the game as it does in advent.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define OUTHIGH 16384 // unsent output at which input is left unread
+#define MAXANSWERS 16 // questions one command can ask
+#define EVENTS 64
+
+struct session_t {
+	int fd;
+	uint32_t watching; // epoll events asked for
+	bool begun;        // the game has reached its first prompt
+	bool waiting;      // for the answer to a question
+	bool hungup;       // the client has sent all it will
+	bool over;         // close once the output is sent
+	int32_t seed;
+	struct game_t game; // at the prompt, between steps
+	command_t command;  // and the command it prompted within
+	char in[LINESIZE];  // input not yet played
+	size_t inlen;
+	char line[LINESIZE]; // the command being played
+	bool answers[MAXANSWERS];
+	int nanswers;
+	const char *question; // the one waiting, or NULL if asked silently
+	size_t sent;          // step output already sent before a question
+	char *out;            // output not yet sent
+	size_t outpos, outlen, outsize;
+};
+
+static int listener;
+
+/* The step a thread is playing */
+static THREAD_LOCAL struct session_t *playing;
+static THREAD_LOCAL const char *pending; // the line, until handed over
+static THREAD_LOCAL long handover;       // output before the line was read
+static THREAD_LOCAL int asked;           // answers used so far
+static THREAD_LOCAL jmp_buf *questioned;
+
+char *myreadline(const char *prompt) {
+	/* Only saving and restoring read this way, and they are refused. */
+	(void)prompt;
+	return NULL;
+}
+
+static char *server_readline(const char *prompt) {
+	/* The session's line at the first prompt; no more after it. */
+	fputs(prompt, settings.outfp);
+	if (playing->begun && handover < 0) {
+		handover = ftell(settings.outfp);
+	}
+	const char *line = pending;
+	pending = NULL;
+	return line != NULL ? strdup(line) : NULL;
+}
+
+static bool server_answer(const char *question) {
+	/* Answers the player has given, in order; past those, stop. */
+	if (asked < playing->nanswers) {
+		return playing->answers[asked++];
+	}
+	playing->question = question;
+	longjmp(*questioned, 1);
+}
+
+static void emit(struct session_t *s, const char *text, size_t len) {
+	/* Queue output for the client. */
+	if (s->outpos == s->outlen) {
+		s->outpos = s->outlen = 0;
+	}
+	if (s->outlen + len > s->outsize) {
+		s->outsize = (s->outlen + len) * 2;
+		s->out = realloc(s->out, s->outsize);
+		if (s->out == NULL) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Out of memory!\n");
+			exit(EXIT_FAILURE);
+			// LCOV_EXCL_STOP
+		}
+	}
+	memcpy(s->out + s->outlen, text, len);
+	s->outlen += len;
+}
+
+static void play(struct session_t *s) {
+	/* The main() loop, from a new game or from the session's prompt;
+	 * at end of input, the ending main() gives. */
+	if (!s->begun) {
+		reset_command();
+		initialise();
+		set_seed(s->seed);
+		bool novice = yes_or_no(arbitrary_messages[WELCOME_YOU],
+		                        arbitrary_messages[CAVE_NEARBY],
+		                        arbitrary_messages[NO_MESSAGE]);
+		ZSET(game.novice, novice);
+		if (game.novice) {
+			ZSET(game.limit, NOVICELIMIT);
+		}
+	} else {
+		game = s->game;
+		zobrist_rehash();
+		resume_command(&s->command);
+	}
+	for (bool moving = !s->begun;; moving = true) {
+		if (moving && !do_move()) {
+			continue;
+		}
+		if (!do_command()) {
+			break;
+		}
+	}
+	if (s->hungup) {
+		terminate(quitgame);
+	}
+}
+
+static void step(struct session_t *s) {
+	/* Play the session's game on to the next prompt or question. */
+	enum { RAN, ASKED, ENDED } outcome;
+	jmp_buf over, held;
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *out = open_memstream(&buf, &len);
+
+	if (out == NULL) {
+		s->over = true; // LCOV_EXCL_LINE
+		return;         // LCOV_EXCL_LINE
+	}
+	settings.outfp = out;
+	settings.exitjmp = &over;
+	questioned = &held;
+	playing = s;
+	pending = s->begun && !s->hungup ? s->line : NULL;
+	handover = -1;
+	asked = 0;
+	if (setjmp(held) != 0) {
+		outcome = ASKED;
+	} else if (setjmp(over) != 0) {
+		outcome = ENDED;
+	} else {
+		play(s);
+		outcome = RAN;
+	}
+	settings.exitjmp = NULL;
+	fclose(out);
+
+	/* The step's output starts with the prompt the last one sent */
+	size_t from = handover > 0 ? (size_t)handover : 0;
+	if (s->sent > from) {
+		from = s->sent;
+	}
+	if (len > from) {
+		emit(s, buf + from, len - from);
+	}
+	free(buf);
+	switch (outcome) {
+	case RAN:
+		s->game = game;
+		park_command(&s->command);
+		s->begun = true;
+		s->sent = 0;
+		s->nanswers = 0;
+		break;
+	case ASKED:
+		s->sent = len;
+		s->waiting = true;
+		emit(s, "\n" PROMPT, strlen("\n" PROMPT));
+		break;
+	case ENDED:
+		s->over = true;
+		break;
+	}
+}
+
+static void reply(struct session_t *s, const char *line) {
+	/* Play a line of input: an answer, or the next command. */
+	if (!s->waiting) {
+		snprintf(s->line, sizeof(s->line), "%s", line);
+		step(s);
+		return;
+	}
+	while (isspace((unsigned char)*line)) {
+		line++;
+	}
+	char first = tolower((unsigned char)*line);
+	if ((first == 'y' || first == 'n') && s->nanswers < MAXANSWERS) {
+		s->answers[s->nanswers++] = first == 'y';
+		s->waiting = false;
+		step(s);
+		return;
+	}
+	/* As yes_or_no() would have it, asking again */
+	char again[LINESIZE * 2];
+	int n = snprintf(again, sizeof(again), "\n%s\n",
+	                 arbitrary_messages[PLEASE_ANSWER]);
+	if (s->question != NULL) {
+		n += snprintf(again + n, sizeof(again) - n, "\n%s\n",
+		              s->question);
+	}
+	snprintf(again + n, sizeof(again) - n, "\n" PROMPT);
+	emit(s, again, strlen(again));
+}
+
+static void pump(struct session_t *s) {
+	/* Play buffered lines while the output isn't backed up. */
+	while (!s->over && s->outlen - s->outpos < OUTHIGH) {
+		char *nl = memchr(s->in, '\n', s->inlen);
+		size_t n;
+		if (nl != NULL) {
+			n = nl - s->in;
+		} else if (s->inlen == sizeof(s->in) - 1 ||
+		           (s->hungup && s->inlen > 0)) {
+			n = s->inlen; // overlong, or the last line
+		} else {
+			break;
+		}
+		char line[LINESIZE];
+		memcpy(line, s->in, n);
+		line[n] = '\0';
+		if (n > 0 && line[n - 1] == '\r') {
+			line[n - 1] = '\0';
+		}
+		n += nl != NULL;
+		memmove(s->in, s->in + n, s->inlen - n);
+		s->inlen -= n;
+		reply(s, line);
+	}
+	if (s->hungup && s->inlen == 0 && !s->over) {
+		if (s->begun && !s->waiting) {
+			step(s); // ends the game
+		}
+		s->over = true;
+	}
+}
+
+static bool flush(struct session_t *s) {
+	/* Send what the socket will take; false if the client is gone. */
+	while (s->outpos < s->outlen) {
+		ssize_t n = send(s->fd, s->out + s->outpos, s->outlen - s->outpos,
+		                 MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (n < 0) {
+			return errno == EAGAIN || errno == EWOULDBLOCK ||
+			       errno == EINTR;
+		}
+		s->outpos += n;
+	}
+	return true;
+}
+
+static void finish(int ep, struct session_t *s) {
+	epoll_ctl(ep, EPOLL_CTL_DEL, s->fd, NULL);
+	close(s->fd);
+	free(s->out);
+	free(s);
+}
+
+static void update(int ep, struct session_t *s) {
+	/* Send, then watch for what the session can use next. */
+	if (!flush(s) || (s->over && s->outpos == s->outlen)) {
+		finish(ep, s);
+		return;
+	}
+	uint32_t want = 0;
+	if (s->outpos < s->outlen) {
+		want |= EPOLLOUT;
+	}
+	if (!s->over && !s->hungup && s->outlen - s->outpos < OUTHIGH) {
+		want |= EPOLLIN;
+	}
+	if (want != s->watching) {
+		struct epoll_event ev = {.events = want, .data.ptr = s};
+		epoll_ctl(ep, EPOLL_CTL_MOD, s->fd, &ev);
+		s->watching = want;
+	}
+}
+
+static uint32_t xorshift(uint32_t *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static void welcome(int ep, uint32_t *rng) {
+	/* Take one connection, if there is one, and start its game. */
+	int fd = accept(listener, NULL, NULL);
+	if (fd < 0) {
+		return;
+	}
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+	struct session_t *s = calloc(1, sizeof(struct session_t));
+	if (s == NULL) {
+		close(fd); // LCOV_EXCL_LINE
+		return;    // LCOV_EXCL_LINE
+	}
+	s->fd = fd;
+	s->seed = (int32_t)(xorshift(rng) & 0x7fffffff);
+	s->watching = EPOLLIN;
+	struct epoll_event ev = {.events = EPOLLIN, .data.ptr = s};
+	if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+		close(fd); // LCOV_EXCL_LINE
+		free(s);   // LCOV_EXCL_LINE
+		return;    // LCOV_EXCL_LINE
+	}
+	step(s);
+	update(ep, s);
+}
+
+static void heard(int ep, struct session_t *s) {
+	/* Read what the client sent and play it. */
+	if (s->inlen < sizeof(s->in) - 1) {
+		ssize_t n = recv(s->fd, s->in + s->inlen,
+		                 sizeof(s->in) - 1 - s->inlen, MSG_DONTWAIT);
+		if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+			s->hungup = true;
+		} else if (n > 0) {
+			s->inlen += n;
+		}
+	}
+	pump(s);
+	update(ep, s);
+}
+
+static void *reactor(void *arg) {
+	/* One thread's event loop over the sessions it accepted. */
+	uint32_t rng = (uint32_t)time(NULL) ^ (uint32_t)(uintptr_t)arg * 2654435761u;
+	struct epoll_event events[EVENTS];
+	int ep = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event ev = {.events = EPOLLIN | EPOLLEXCLUSIVE,
+	                         .data.ptr = NULL};
+
+	if (rng == 0) {
+		rng = 1; // LCOV_EXCL_LINE
+	}
+	if (ep < 0 || epoll_ctl(ep, EPOLL_CTL_ADD, listener, &ev) != 0) {
+		perror("advent-server: epoll"); // LCOV_EXCL_LINE
+		exit(EXIT_FAILURE);              // LCOV_EXCL_LINE
+	}
+	memset(&settings, 0, sizeof(settings));
+	settings.prompt = true;
+	settings.interactive = true; // the client's terminal echoes
+	settings.readline = server_readline;
+	settings.answer = server_answer;
+	settings.nosave = true;
+	for (;;) {
+		int n = epoll_wait(ep, events, EVENTS, -1);
+		for (int i = 0; i < n; i++) {
+			struct session_t *s = events[i].data.ptr;
+			if (s == NULL) {
+				welcome(ep, &rng);
+			} else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+				heard(ep, s);
+			} else {
+				pump(s);
+				update(ep, s);
+			}
+		}
+	}
+	return NULL;
+}
+
+static int listen_on(const char *where, bool unix_socket) {
+	/* A listening socket on a Unix path, or on [address:]port. */
+	int fd;
+
+	if (unix_socket) {
+		struct sockaddr_un sun = {.sun_family = AF_UNIX};
+		if (strlen(where) >= sizeof(sun.sun_path)) {
+			return -1;
+		}
+		strcpy(sun.sun_path, where);
+		unlink(where);
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0 || bind(fd, (struct sockaddr *)&sun, sizeof(sun)) != 0) {
+			return -1;
+		}
+	} else {
+		struct sockaddr_in sin = {.sin_family = AF_INET};
+		const char *colon = strrchr(where, ':');
+		char host[64] = "127.0.0.1";
+		if (colon != NULL) {
+			snprintf(host, sizeof(host), "%.*s", (int)(colon - where),
+			         where);
+			where = colon + 1;
+		}
+		sin.sin_port = htons(atoi(where));
+		if (inet_pton(AF_INET, host, &sin.sin_addr) != 1) {
+			return -1;
+		}
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		int one = 1;
+		if (fd < 0 ||
+		    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+		    bind(fd, (struct sockaddr *)&sin, sizeof(sin)) != 0) {
+			return -1;
+		}
+	}
+	return listen(fd, SOMAXCONN) == 0 ? fd : -1;
+}
+
+int main(int argc, char *argv[]) {
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	const char *where = NULL;
+	bool unix_socket = false;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "j:p:u:")) != EOF) {
+		switch (ch) {
+		case 'j':
+			jobs = atol(optarg);
+			break;
+		case 'p':
+			where = optarg;
+			unix_socket = false;
+			break;
+		case 'u':
+			where = optarg;
+			unix_socket = true;
+			break;
+		default:
+			where = NULL;
+			optind = argc;
+			break;
+		}
+	}
+	if (where == NULL || optind != argc) {
+		fprintf(stderr,
+		        "Usage: %s [-j threads] -p [address:]port | -u path\n",
+		        argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+	if ((listener = listen_on(where, unix_socket)) < 0) {
+		perror(where);
+		exit(EXIT_FAILURE);
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+	pthread_t *pool = calloc(jobs, sizeof(pthread_t));
+	for (long i = 0; i < jobs; i++) {
+		pthread_create(&pool[i], NULL, reactor, (void *)(uintptr_t)i);
+	}
+	for (long i = 0; i < jobs; i++) {
+		pthread_join(pool[i], NULL);
+	}
+	return EXIT_SUCCESS;
+}
+
+/* end */
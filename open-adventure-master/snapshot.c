@@ -0,0 +1,158 @@
+/*
+ * Copy-on-write game state snapshots.
+ *
+ * A snapshot holds the scalar part of struct game_t inline and the big
+ * per-location, per-dwarf, per-object, per-hint and link arrays in
+ * reference-counted chunks.  Forking a snapshot only bumps reference
+ * counts; a chunk is copied the first time one of its sharers asks to
+ * write it.  Capturing the live game against a parent snapshot reuses
+ * every parent chunk whose contents did not change, so a search tree
+ * pays for the arrays a move actually touched and nothing else.
+ *
+ * Reference counts and the heap total are updated atomically, so
+ * snapshots sharing chunks may be taken, restored and freed on
+ * different threads; a single snapshot belongs to one thread at a time.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "advent.h"
+
+struct snapchunk_t {
+	int refs;
+	unsigned char data[];
+};
+
+/* Where each shared section lives inside struct game_t */
+static const struct {
+	size_t offset;
+	size_t size;
+} sections[SNAP_SECTIONS] = {
+    [SNAP_LOCS] = {offsetof(struct game_t, locs), sizeof(game.locs)},
+    [SNAP_DWARVES] = {offsetof(struct game_t, dwarves), sizeof(game.dwarves)},
+    [SNAP_OBJECTS] = {offsetof(struct game_t, objects), sizeof(game.objects)},
+    [SNAP_HINTS] = {offsetof(struct game_t, hints), sizeof(game.hints)},
+    [SNAP_LINK] = {offsetof(struct game_t, link), sizeof(game.link)},
+};
+
+static size_t live_bytes; // heap held by snapshots and their chunks
+
+static void *snap_alloc(size_t size) {
+	void *ptr = malloc(size);
+	if (ptr == NULL) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Out of memory!\n");
+		exit(EXIT_FAILURE);
+		// LCOV_EXCL_STOP
+	}
+	__atomic_fetch_add(&live_bytes, size, __ATOMIC_RELAXED);
+	return ptr;
+}
+
+static struct snapchunk_t *chunk_new(int section, const void *src) {
+	struct snapchunk_t *chunk =
+	    snap_alloc(sizeof(struct snapchunk_t) + sections[section].size);
+	chunk->refs = 1;
+	memcpy(chunk->data, src, sections[section].size);
+	return chunk;
+}
+
+static void chunk_release(int section, struct snapchunk_t *chunk) {
+	if (__atomic_sub_fetch(&chunk->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+		__atomic_fetch_sub(&live_bytes,
+		                   sizeof(struct snapchunk_t) + sections[section].size,
+		                   __ATOMIC_RELAXED);
+		free(chunk);
+	}
+}
+
+struct snapshot_t *snapshot_take(const struct snapshot_t *parent) {
+	/* Capture the live game.  Sections equal to the parent's are
+	 * shared with it rather than copied. */
+	struct snapshot_t *snap = snap_alloc(sizeof(struct snapshot_t));
+	const unsigned char *live = (const unsigned char *)&game;
+
+	memcpy(snap->head, live, sizeof(snap->head));
+	snap->zobrist = game_zobrist;
+	snap->rehash = false;
+	for (int i = 0; i < SNAP_SECTIONS; i++) {
+		const void *src = live + sections[i].offset;
+		if (parent != NULL &&
+		    memcmp(parent->chunk[i]->data, src, sections[i].size) ==
+		        0) {
+			snap->chunk[i] = parent->chunk[i];
+			__atomic_fetch_add(&snap->chunk[i]->refs, 1,
+			                   __ATOMIC_RELAXED);
+		} else {
+			snap->chunk[i] = chunk_new(i, src);
+		}
+	}
+	return snap;
+}
+
+struct snapshot_t *snapshot_fork(const struct snapshot_t *parent) {
+	/* Make a child that shares everything with its parent. */
+	struct snapshot_t *snap = snap_alloc(sizeof(struct snapshot_t));
+
+	memcpy(snap->head, parent->head, sizeof(snap->head));
+	snap->zobrist = parent->zobrist;
+	snap->rehash = parent->rehash;
+	for (int i = 0; i < SNAP_SECTIONS; i++) {
+		snap->chunk[i] = parent->chunk[i];
+		__atomic_fetch_add(&snap->chunk[i]->refs, 1, __ATOMIC_RELAXED);
+	}
+	return snap;
+}
+
+void *snapshot_write(struct snapshot_t *snap, enum snapsection section) {
+	/* Return a private, writable copy of one section, copying it
+	 * first if anyone else still shares it.  The snapshot's hash is
+	 * recomputed when it is next restored. */
+	struct snapchunk_t *chunk = snap->chunk[section];
+	snap->rehash = true;
+	if (__atomic_load_n(&chunk->refs, __ATOMIC_ACQUIRE) > 1) {
+		snap->chunk[section] = chunk_new(section, chunk->data);
+		chunk_release(section, chunk);
+	}
+	return snap->chunk[section]->data;
+}
+
+void snapshot_restore(const struct snapshot_t *snap) {
+	/* Make a snapshot the live game. */
+	unsigned char *live = (unsigned char *)&game;
+
+	memcpy(live, snap->head, sizeof(snap->head));
+	for (int i = 0; i < SNAP_SECTIONS; i++) {
+		memcpy(live + sections[i].offset, snap->chunk[i]->data,
+		       sections[i].size);
+	}
+	if (snap->rehash) {
+		zobrist_rehash();
+	} else {
+		game_zobrist = snap->zobrist;
+	}
+}
+
+void snapshot_free(struct snapshot_t *snap) {
+	if (snap == NULL) {
+		return;
+	}
+	for (int i = 0; i < SNAP_SECTIONS; i++) {
+		chunk_release(i, snap->chunk[i]);
+	}
+	__atomic_fetch_sub(&live_bytes, sizeof(struct snapshot_t),
+	                   __ATOMIC_RELAXED);
+	free(snap);
+}
+
+size_t snapshot_memory(void) {
+	/* Heap currently held by all live snapshots. */
+	return __atomic_load_n(&live_bytes, __ATOMIC_RELAXED);
+}
+
+/* end */
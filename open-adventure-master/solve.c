@@ -0,0 +1,633 @@
+/*
+ * 'advent-solve' searches the game for the fewest turns from the start
+ * (or from a save, with -r) to a goal:
+ *	treasures	every treasure lying in the building
+ *	closed		the cave closed, player in the repository
+ *	win		the endgame won with all 430 points, less any
+ *			penalties for hints, saves and slowness
+ *	N		standing at location N
+ * and writes the winning command sequence as a log advent can replay.
+ *
+ * The search is breadth-first, one turn per level, so the first goal
+ * state found is a shortest one.  Every state on the frontier is kept
+ * as a copy-on-write snapshot and expanded by restoring it and playing
+ * each plausible command: the motions in the travel table here, a
+ * fixed set of verbs on each object in reach, and the magic words.
+ * A node is a game waiting at the command prompt; a command runs until
+ * the game wants the next one (see await_command()).  Yes/no questions
+ * are answered through settings.answer: yes to "with your bare
+ * hands?", no to hints and to reincarnation, so a command that kills
+ * the player is a dead end.  The answers go into the log too.
+ *
+ * States already seen are skipped through a lock-free transposition
+ * table of Zobrist keys (see zobrist.c).  The key leaves out fields
+ * that cannot affect play here, such as the turn counter, so reaching
+ * a state again by a longer or different route costs nothing.
+ * Each thread expands nodes from its own deque and steals from the
+ * others' when it runs dry; children go to the expanding thread's
+ * share of the next level.
+ *
+ * Progress goes to standard error, one line per level.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <ctype.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WIN_POINTS 430 // the most there are, as terminate() reports
+
+enum goal { GOAL_TREASURES, GOAL_CLOSED, GOAL_WIN, GOAL_LOCATION };
+
+struct node_t {
+	struct node_t *parent;
+	struct snapshot_t *snap; // NULL once expanded
+	char *lines;             // input that led here, newline-separated
+};
+
+struct deque_t {
+	pthread_mutex_t lock;
+	struct node_t **item;
+	size_t head, tail; // item[head..tail) are waiting
+	size_t size;
+};
+
+struct worker_t {
+	pthread_t thread;
+	int id;
+	struct deque_t work;  // this level's nodes
+	struct node_t **next; // children, for the next level
+	size_t nnext, nextsize;
+	unsigned long steps;
+};
+
+/* Commands tried on each object in reach */
+static const int verbs[] = {CARRY, DROP,  UNLOCK, LOCK,   LIGHT,
+                            EXTINGUISH,   WAVE,   ATTACK, POUR,
+                            EAT,   DRINK, RUB,    THROW,  FEED,
+                            FILL,  READ,  BREAK,  WAKE,   FLY};
+/* and on their own */
+static const int intransitives[] = {FEE, FIE, FOE, FOO, BLAST};
+
+static enum goal goal;
+static loc_t goal_loc;
+static char preamble[32]; // the seed command, ahead of the first move
+
+static struct worker_t *workers;
+static int njobs;
+static pthread_barrier_t level_done, level_start;
+static bool stopping;
+static struct node_t *found;
+static int depth, maxdepth;
+static double started;
+
+/* Words of struct game_t holding fields left out of position() */
+static struct {
+	size_t word;
+	uint64_t mask;
+} ignored[(sizeof(struct game_t) + 7) / 8];
+static int nignored;
+
+static uint64_t *table; // position() of states seen, 0 for empty
+static size_t tablemask;
+static size_t states, maxstates;
+
+static THREAD_LOCAL struct worker_t *self;
+static THREAD_LOCAL const char *script[2];
+static THREAD_LOCAL int nscript, scriptpos;
+static THREAD_LOCAL char said[LINESIZE]; // script and answers used
+
+static void *xmalloc(size_t size) {
+	void *ptr = malloc(size);
+	if (ptr == NULL) {
+		// LCOV_EXCL_START
+		fprintf(stderr, "Out of memory!\n");
+		exit(EXIT_FAILURE);
+		// LCOV_EXCL_STOP
+	}
+	return ptr;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void note(const char *line) {
+	/* Add a line of input to the log of the current step. */
+	size_t len = strlen(said);
+	snprintf(said + len, sizeof(said) - len, "%s\n", line);
+}
+
+char *myreadline(const char *prompt) {
+	/* Hand the engine the step's command.  When that is gone, the
+	 * game is waiting for the next one and the step is over. */
+	(void)prompt;
+	if (scriptpos == nscript) {
+		return NULL;
+	}
+	note(script[scriptpos]);
+	return strdup(script[scriptpos++]);
+}
+
+static bool answer(const char *question) {
+	/* Only the dragon question is asked silently, and only it is
+	 * worth a yes. */
+	bool yes = question == NULL;
+	note(yes ? "yes" : "no");
+	return yes;
+}
+
+static void ignore_fields(void) {
+	/* Note which bits of the game never change what a command does
+	 * under this search: the clock, where the player was before (only
+	 * "back", hints and resurrection use that), how often each room
+	 * was seen and each hint nearly offered, and the nag counters.
+	 * States differing only in those are one state. */
+	struct game_t m;
+
+	memset(&m, 0, sizeof(m));
+	memset(&m.turns, 0xff, sizeof(m.turns));
+	memset(&m.oldloc, 0xff, sizeof(m.oldloc));
+	memset(&m.oldlc2, 0xff, sizeof(m.oldlc2));
+	memset(&m.iwest, 0xff, sizeof(m.iwest));
+	memset(&m.igo, 0xff, sizeof(m.igo));
+	for (int i = 0; i <= NLOCATIONS; i++) {
+		memset(&m.locs[i].abbrev, 0xff, sizeof(m.locs[i].abbrev));
+	}
+	for (int i = 0; i < NHINTS; i++) {
+		memset(&m.hints[i].lc, 0xff, sizeof(m.hints[i].lc));
+	}
+	for (size_t w = 0; w < (sizeof(m) + 7) / 8; w++) {
+		uint64_t mask = zobrist_word(&m, w);
+		if (mask != 0) {
+			ignored[nignored].word = w;
+			ignored[nignored++].mask = mask;
+		}
+	}
+}
+
+static uint64_t position(void) {
+	/* game_zobrist as if the ignored fields were all zero */
+	uint64_t hash = game_zobrist;
+
+	for (int i = 0; i < nignored; i++) {
+		size_t w = ignored[i].word;
+		uint64_t word = zobrist_word(&game, w);
+		if ((word & ignored[i].mask) != 0) {
+			hash ^= zobrist_key(w, word) ^
+			        zobrist_key(w, word & ~ignored[i].mask);
+		}
+	}
+	return hash;
+}
+
+static bool claim(uint64_t key) {
+	/* Enter a state in the table; false if it was already there, or if
+	 * maxstates are in it already.  A state is counted before it takes
+	 * a slot, so the table (twice maxstates) always has an empty one
+	 * to end the probe. */
+	bool counted = false;
+	size_t i;
+
+	if (key == 0) {
+		key = 1;
+	}
+	for (i = key & tablemask;; i = (i + 1) & tablemask) {
+		uint64_t seen = __atomic_load_n(&table[i], __ATOMIC_RELAXED);
+		if (seen == 0 && !counted) {
+			if (__atomic_fetch_add(&states, 1, __ATOMIC_RELAXED) >=
+			    maxstates) {
+				__atomic_fetch_sub(&states, 1, __ATOMIC_RELAXED);
+				return false;
+			}
+			counted = true;
+		}
+		while (seen == 0) {
+			if (__atomic_compare_exchange_n(&table[i], &seen, key,
+			                                false, __ATOMIC_RELAXED,
+			                                __ATOMIC_RELAXED)) {
+				return true;
+			}
+		}
+		if (seen == key) {
+			if (counted) {
+				__atomic_fetch_sub(&states, 1, __ATOMIC_RELAXED);
+			}
+			return false;
+		}
+	}
+}
+
+static bool reached(void) {
+	/* Is the live game at the goal?  A won game only gets this far if
+	 * step() found its score perfect. */
+	switch (goal) {
+	case GOAL_TREASURES:
+		for (obj_t obj = 1; obj <= NOBJECTS; obj++) {
+			if (objects[obj].is_treasure &&
+			    game.objects[obj].place != LOC_BUILDING) {
+				return false;
+			}
+		}
+		return true;
+	case GOAL_CLOSED:
+		return game.closed;
+	case GOAL_WIN:
+		return game.bonus == victory;
+	case GOAL_LOCATION:
+		return game.loc == goal_loc;
+	default:
+		return false; // LCOV_EXCL_LINE
+	}
+}
+
+static int penalties(void) {
+	/* Points score() takes off for help and delay; a save brought
+	 * into the search has paid some already. */
+	int lost = game.trnluz + game.saved;
+
+	for (int i = 0; i < NHINTS; i++) {
+		if (game.hints[i].used) {
+			lost += hints[i].penalty;
+		}
+	}
+	if (game.novice) {
+		lost += 5;
+	}
+	if (game.clshnt) {
+		lost += 10;
+	}
+	return lost;
+}
+
+static struct node_t *step(struct node_t *from, const char *command) {
+	/* Play one command from a node, as main() would, until the game
+	 * wants another.  Returns the resulting node, or NULL if the
+	 * command led nowhere useful. */
+	turn_t turns;
+	jmp_buf over;
+
+	snapshot_restore(from->snap);
+	turns = game.turns;
+	nscript = scriptpos = 0;
+	if (from->parent == NULL && preamble[0] != '\0') {
+		script[nscript++] = preamble;
+	}
+	script[nscript++] = command;
+	said[0] = '\0';
+	self->steps++;
+
+	settings.exitjmp = &over;
+	if (setjmp(over) == 0) {
+		await_command();
+		while (do_command()) {
+			while (!do_move()) {
+				continue;
+			}
+		}
+	} else if (goal != GOAL_WIN || game.bonus != victory ||
+	           score(endgame) + penalties() != WIN_POINTS) {
+		return NULL; // dead, quit, or won with treasures missing
+	}
+	if (game.turns != turns + 1 || !claim(position())) {
+		return NULL;
+	}
+
+	struct node_t *node = xmalloc(sizeof(struct node_t));
+	node->parent = from;
+	node->snap = snapshot_take(from->snap);
+	node->lines = strdup(said);
+	return node;
+}
+
+static void push(struct worker_t *w, struct node_t *node) {
+	/* Queue a child for the next level. */
+	if (w->nnext == w->nextsize) {
+		w->nextsize = w->nextsize ? w->nextsize * 2 : 1024;
+		w->next = realloc(w->next, w->nextsize * sizeof(struct node_t *));
+		if (w->next == NULL) {
+			// LCOV_EXCL_START
+			fprintf(stderr, "Out of memory!\n");
+			exit(EXIT_FAILURE);
+			// LCOV_EXCL_STOP
+		}
+	}
+	w->next[w->nnext++] = node;
+}
+
+static void try(struct worker_t *w, struct node_t *from, const char *command) {
+	struct node_t *node = step(from, command);
+	if (node == NULL) {
+		return;
+	}
+	push(w, node);
+	if (reached()) {
+		struct node_t *none = NULL;
+		__atomic_compare_exchange_n(&found, &none, node, false,
+		                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+	}
+}
+
+static void expand(struct worker_t *w, struct node_t *node) {
+	/* Try every plausible command at a node. */
+	char command[LINESIZE];
+	bool inreach[NOBJECTS + 1] = {false};
+	bool moved[NMOTIONS + 1] = {false};
+
+	snapshot_restore(node->snap);
+	loc_t loc = game.loc;
+	int kk = tkey[loc];
+	if (kk != 0) {
+		do {
+			moved[travel[kk].motion] = true;
+		} while (!travel[kk++].stop);
+	}
+	for (obj_t obj = 1; obj <= NOBJECTS; obj++) {
+		inreach[obj] = game.objects[obj].place == CARRIED ||
+		               game.objects[obj].place == loc ||
+		               game.objects[obj].fixed == loc;
+	}
+	inreach[DWARF] = atdwrf(loc) > 0;
+
+	for (int m = 1; m <= NMOTIONS; m++) {
+		if (moved[m] && motions[m].words.n > 0) {
+			try(w, node, motions[m].words.strs[0]);
+		}
+	}
+	for (obj_t obj = 1; obj <= NOBJECTS; obj++) {
+		if (!inreach[obj] || objects[obj].words.n == 0) {
+			continue;
+		}
+		for (size_t v = 0; v < sizeof(verbs) / sizeof(verbs[0]); v++) {
+			snprintf(command, sizeof(command), "%s %s",
+			         actions[verbs[v]].words.strs[0],
+			         objects[obj].words.strs[0]);
+			try(w, node, command);
+		}
+	}
+	for (size_t v = 0;
+	     v < sizeof(intransitives) / sizeof(intransitives[0]); v++) {
+		try(w, node, actions[intransitives[v]].words.strs[0]);
+	}
+
+	snapshot_free(node->snap);
+	node->snap = NULL;
+}
+
+static struct node_t *take(struct worker_t *w) {
+	/* Next node from the back of our own deque, or else from the front
+	 * of someone else's.  Nothing is added to a deque mid-level, so
+	 * finding them all empty means the level is done. */
+	for (int k = 0; k < njobs; k++) {
+		struct deque_t *d = &workers[(w->id + k) % njobs].work;
+		struct node_t *node = NULL;
+
+		pthread_mutex_lock(&d->lock);
+		if (d->head < d->tail) {
+			node = k == 0 ? d->item[--d->tail] : d->item[d->head++];
+		}
+		pthread_mutex_unlock(&d->lock);
+		if (node != NULL) {
+			return node;
+		}
+	}
+	return NULL;
+}
+
+static void next_level(void) {
+	/* Between levels, on one thread: report, decide whether to go on,
+	 * and turn each thread's children into its work. */
+	size_t frontier = 0;
+	unsigned long steps = 0;
+
+	depth++;
+	for (int i = 0; i < njobs; i++) {
+		struct worker_t *w = &workers[i];
+		free(w->work.item);
+		w->work.item = w->next;
+		w->work.size = w->nextsize;
+		w->work.head = 0;
+		w->work.tail = w->nnext;
+		frontier += w->nnext;
+		steps += w->steps;
+		w->next = NULL;
+		w->nnext = w->nextsize = 0;
+	}
+	double elapsed = now() - started;
+	fprintf(stderr,
+	        "turn %d: %zu new states, %zu seen, %.0f moves/s, "
+	        "%zu MB in snapshots\n",
+	        depth, frontier, states, elapsed > 0 ? steps / elapsed : 0,
+	        snapshot_memory() >> 20);
+	if (found != NULL || frontier == 0 || states >= maxstates ||
+	    depth >= maxdepth) {
+		stopping = true;
+	}
+}
+
+static void *worker(void *arg) {
+	/* Expand nodes level by level until the search stops. */
+	self = arg;
+	memset(&settings, 0, sizeof(settings));
+	settings.silent = true;
+	settings.answer = answer;
+
+	while (!stopping) {
+		struct node_t *node;
+		while ((node = take(self)) != NULL) {
+			if (__atomic_load_n(&states, __ATOMIC_RELAXED) <
+			    maxstates) {
+				expand(self, node);
+			}
+		}
+		if (pthread_barrier_wait(&level_done) ==
+		    PTHREAD_BARRIER_SERIAL_THREAD) {
+			next_level();
+		}
+		pthread_barrier_wait(&level_start);
+	}
+	return NULL;
+}
+
+static struct node_t *root(FILE *rfp, int32_t seed) {
+	/* Start a game the way main() does, up to its first prompt. */
+	struct node_t *node = xmalloc(sizeof(struct node_t));
+	jmp_buf over;
+
+	memset(&settings, 0, sizeof(settings));
+	settings.outfp = stderr; // only restore() has anything to say
+	settings.exitjmp = &over;
+	if (setjmp(over) != 0) {
+		exit(EXIT_FAILURE);
+	}
+	initialise();
+	if (rfp != NULL) {
+		restore(rfp);
+	} else {
+		ZSET(game.novice, false);
+		snprintf(preamble, sizeof(preamble), "seed %d", (int)seed);
+	}
+	settings.silent = true;
+	settings.answer = answer;
+	for (;;) {
+		if (!do_move()) {
+			continue;
+		}
+		if (!do_command()) {
+			break;
+		}
+	}
+	settings.exitjmp = NULL;
+
+	node->parent = NULL;
+	node->snap = snapshot_take(NULL);
+	node->lines = strdup(said);
+	claim(position());
+	return node;
+}
+
+static void print_path(struct node_t *node, const char *goalname) {
+	/* Write the route to a node as a log advent can replay. */
+	int turns = 0;
+	struct node_t **path;
+
+	for (struct node_t *n = node; n->parent != NULL; n = n->parent) {
+		turns++;
+	}
+	path = xmalloc((turns + 1) * sizeof(struct node_t *));
+	int i = turns + 1;
+	for (struct node_t *n = node; n != NULL; n = n->parent) {
+		path[--i] = n;
+	}
+	printf("## advent-solve: %s in %d turns\n", goalname, turns);
+	if (preamble[0] != '\0') {
+		printf("n\n"); // no instructions
+	}
+	for (i = 0; i <= turns; i++) {
+		fputs(path[i]->lines, stdout);
+	}
+	free(path);
+}
+
+int main(int argc, char *argv[]) {
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	int32_t seed = 1;
+	const char *goalname = "win";
+	FILE *rfp = NULL;
+	int ch;
+
+	maxdepth = 1000;
+	maxstates = 1000000;
+	while ((ch = getopt(argc, argv, "d:g:j:m:r:s:")) != EOF) {
+		switch (ch) {
+		case 'd':
+			maxdepth = atoi(optarg);
+			break;
+		case 'g':
+			goalname = optarg;
+			break;
+		case 'j':
+			jobs = atol(optarg);
+			break;
+		case 'm':
+			maxstates = strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			rfp = fopen(optarg, "r");
+			if (rfp == NULL) {
+				perror(optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 's':
+			seed = atol(optarg);
+			break;
+		default:
+			fprintf(stderr,
+			        "Usage: %s [-g treasures|closed|win|location] "
+			        "[-r savefile] [-s seed]\n"
+			        "       [-j threads] [-d maxturns] [-m maxstates]\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (strcmp(goalname, "treasures") == 0) {
+		goal = GOAL_TREASURES;
+	} else if (strcmp(goalname, "closed") == 0) {
+		goal = GOAL_CLOSED;
+	} else if (strcmp(goalname, "win") == 0) {
+		goal = GOAL_WIN;
+	} else if (isdigit((unsigned char)goalname[0]) &&
+	           (goal_loc = atoi(goalname)) <= NLOCATIONS) {
+		goal = GOAL_LOCATION;
+	} else {
+		fprintf(stderr, "%s: unknown goal %s\n", argv[0], goalname);
+		exit(EXIT_FAILURE);
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+	if (maxstates < 1) {
+		maxstates = 1;
+	}
+
+	/* At most half full, so probes stay short */
+	size_t slots = 1;
+	while (slots < 2 * maxstates) {
+		slots *= 2;
+	}
+	table = calloc(slots, sizeof(uint64_t));
+	if (table == NULL) {
+		fprintf(stderr, "%s: no memory for %zu states\n", argv[0],
+		        maxstates);
+		exit(EXIT_FAILURE);
+	}
+	tablemask = slots - 1;
+	ignore_fields();
+
+	struct node_t *start = root(rfp, seed);
+	if (reached()) {
+		found = start;
+	}
+
+	njobs = jobs;
+	workers = calloc(njobs, sizeof(struct worker_t));
+	pthread_barrier_init(&level_done, NULL, njobs);
+	pthread_barrier_init(&level_start, NULL, njobs);
+	for (int i = 0; i < njobs; i++) {
+		workers[i].id = i;
+		pthread_mutex_init(&workers[i].work.lock, NULL);
+	}
+	workers[0].work.item = xmalloc(sizeof(struct node_t *));
+	workers[0].work.item[0] = start;
+	workers[0].work.tail = workers[0].work.size = 1;
+	stopping = found != NULL;
+	started = now();
+	for (int i = 0; i < njobs; i++) {
+		pthread_create(&workers[i].thread, NULL, worker, &workers[i]);
+	}
+	for (int i = 0; i < njobs; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+
+	if (found == NULL) {
+		fprintf(stderr,
+		        "%s: no way to %s found in %d turns and %zu states%s\n",
+		        argv[0], goalname, depth, states,
+		        states >= maxstates ? " (the -m limit)" : "");
+		return EXIT_FAILURE;
+	}
+	print_path(found, goalname);
+	return EXIT_SUCCESS;
+}
+
+/* end */
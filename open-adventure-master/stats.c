@@ -0,0 +1,127 @@
+/*
+ * Gameplay counters in a shared-memory segment.
+ *
+ * Every advent started with -S on the same file maps it and bumps the
+ * counters there, so the file holds totals across all sessions on the
+ * host.  advstats reads it.
+ *
+ * The file is a struct stats_t: a magic string, the number of counters
+ * in each enum statgroup, then the counters themselves group after
+ * group, each padded to its own cache line so sessions bumping
+ * different counters never contend for a line.  Increments are relaxed
+ * atomic adds and readers use plain atomic loads; nothing on the game
+ * path ever takes a lock.  A reader sees each counter exactly, but not
+ * a snapshot consistent across counters.
+ *
+ * The group sizes in the header are checked on every map, so a file
+ * written against one dungeon is never updated or read against another.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "advent.h"
+
+#define STATS_MAGIC "advent-stats 1"
+
+static const uint32_t group_size[STATS_GROUPS] = {
+    [STATS_GAMES] = 1,
+    [STATS_VERB] = NACTIONS,
+    [STATS_MOTION] = NMOTIONS,
+    [STATS_VISIT] = NLOCATIONS + 1,
+    [STATS_DEATH] = DEATH_CAUSES,
+    [STATS_HINT_OFFERED] = NHINTS,
+    [STATS_HINT_USED] = NHINTS,
+};
+
+/* Where each group starts; the entry past the last is the total */
+#define BASE_VERB 1
+#define BASE_MOTION (BASE_VERB + NACTIONS)
+#define BASE_VISIT (BASE_MOTION + NMOTIONS)
+#define BASE_DEATH (BASE_VISIT + NLOCATIONS + 1)
+#define BASE_HINT_OFFERED (BASE_DEATH + DEATH_CAUSES)
+#define BASE_HINT_USED (BASE_HINT_OFFERED + NHINTS)
+
+static const size_t group_base[STATS_GROUPS + 1] = {
+    0,          BASE_VERB,         BASE_MOTION,    BASE_VISIT,
+    BASE_DEATH, BASE_HINT_OFFERED, BASE_HINT_USED, BASE_HINT_USED + NHINTS,
+};
+
+size_t stats_index(enum statgroup group, int i) {
+	/* Position of a group's i'th counter in the segment.
+	 * stats_index(STATS_GROUPS, 0) is the number of counters. */
+	return group_base[group] + i;
+}
+
+struct stats_t *stats_map(const char *path, bool writable) {
+	/* Map a stats file, creating and laying it out if writable.
+	 * Returns NULL, with a message, if that fails or the file belongs
+	 * to a different dungeon. */
+	size_t size = sizeof(struct stats_t) +
+	              stats_index(STATS_GROUPS, 0) * sizeof(struct statcounter_t);
+	int fd = open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0666);
+	struct stat st;
+
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		perror(path);
+		if (fd >= 0) {
+			close(fd); // LCOV_EXCL_LINE
+		}
+		return NULL;
+	}
+	/* Growing is idempotent, so sessions racing to create the file
+	 * are harmless. */
+	if (writable && (size_t)st.st_size < size && ftruncate(fd, size) < 0) {
+		// LCOV_EXCL_START
+		perror(path);
+		close(fd);
+		return NULL;
+		// LCOV_EXCL_STOP
+	}
+	if (!writable && (size_t)st.st_size < size) {
+		fprintf(stderr, "%s: not an advent stats file\n", path);
+		close(fd);
+		return NULL;
+	}
+
+	struct stats_t *stats =
+	    mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+	         MAP_SHARED, fd, 0);
+	close(fd);
+	if (stats == MAP_FAILED) {
+		perror(path); // LCOV_EXCL_LINE
+		return NULL;  // LCOV_EXCL_LINE
+	}
+
+	if (writable && stats->magic[0] == '\0') {
+		memcpy(stats->size, group_size, sizeof(group_size));
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		memcpy(stats->magic, STATS_MAGIC, sizeof(STATS_MAGIC));
+	}
+	if (memcmp(stats->magic, STATS_MAGIC, sizeof(STATS_MAGIC)) != 0 ||
+	    memcmp(stats->size, group_size, sizeof(group_size)) != 0) {
+		fprintf(stderr, "%s: not a stats file for this dungeon\n",
+		        path);
+		munmap(stats, size);
+		return NULL;
+	}
+	return stats;
+}
+
+void stats_count(struct stats_t *stats, enum statgroup group, int i) {
+	/* Bump one counter; a no-op when stats are off. */
+	if (stats == NULL || i < 0 || (uint32_t)i >= group_size[group]) {
+		return;
+	}
+	__atomic_fetch_add(&stats->counter[stats_index(group, i)].count, 1,
+	                   __ATOMIC_RELAXED);
+}
+
+/* end */
@@ -0,0 +1,370 @@
+/*
+ * 'advent-sweep' plays one command script under every seed the LCG has
+ * (LCG_M of them), or a range given with -s first-last, and reports how
+ * the games came out: the score distribution, how they ended, when the
+ * player died and first met a dwarf, and how the magic word fell.
+ *
+ * The script is read the way advent reads a log on standard input: the
+ * first line answers the offer of instructions, comment lines are
+ * skipped, and the game ends where the script does.  "seed" commands in
+ * it are dropped, since the sweep sets the seed.  Games run in-process
+ * and in silent mode on a pool of threads; each thread takes seeds
+ * from a shared counter a block at a time.  With -l, one line per seed
+ * goes to standard output ahead of the report.
+ *
+ * Timing goes to standard error, so the report itself depends only on
+ * the script and the seeds.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+#include "advent.h"
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BLOCK 256 // seeds a thread takes at a time
+
+/* Quitting, or running out of input, forfeits the points for not
+ * quitting; every later ending is terminate(endgame). */
+enum ending {
+	ENDED_INPUT,
+	ENDED_QUIT,
+	ENDED_DEATH,
+	ENDED_CLOSED,
+	ENDED_WIN,
+	ENDINGS
+};
+
+static const char *endings[ENDINGS] = {"script ran out", "quit", "died",
+                                       "closed", "won"};
+
+/* How one seed's game came out */
+struct result_t {
+	int32_t score;
+	int32_t turns;
+	int32_t death;  // turn of the first death, or -1
+	int32_t dwarf;  // turn a dwarf was first met, or -1
+	int8_t deaths;
+	uint8_t ending;
+	char word[TOKLEN + 1];
+};
+
+static char **lines; // the script, one command per entry
+static int nlines;
+static int32_t first, last;
+static int32_t nextseed;
+static struct result_t *results; // indexed by seed - first
+
+static THREAD_LOCAL int scriptpos;
+static THREAD_LOCAL struct result_t *playing;
+static THREAD_LOCAL bool ranout;
+static THREAD_LOCAL int32_t died; // turn of the latest death
+
+char *myreadline(const char *prompt) {
+	/* All input comes through settings.readline. */
+	(void)prompt;
+	return NULL;
+}
+
+static void notice(void) {
+	/* Note deaths and dwarves as they happen. */
+	if (game.numdie > playing->deaths) {
+		if (playing->death < 0) {
+			playing->death = game.turns;
+		}
+		playing->deaths = game.numdie;
+		died = game.turns;
+	}
+	if (game.dflag >= 2 && playing->dwarf < 0) {
+		playing->dwarf = game.turns;
+	}
+}
+
+static char *script_readline(const char *prompt) {
+	/* The next line of the script, checking on the game first. */
+	(void)prompt;
+	notice();
+	while (scriptpos < nlines) {
+		const char *line = lines[scriptpos++];
+		if (strncasecmp(line, "seed ", 5) != 0) {
+			return strdup(line);
+		}
+	}
+	ranout = true;
+	return NULL;
+}
+
+static void play(int32_t seed, struct result_t *r) {
+	/* One game under one seed, as main() would play the script. */
+	jmp_buf over;
+
+	memset(r, 0, sizeof(*r));
+	r->death = r->dwarf = -1;
+	playing = r;
+	scriptpos = 0;
+	ranout = false;
+	died = -1;
+	settings.exitjmp = &over;
+	if (setjmp(over) == 0) {
+		reset_command();
+		initialise();
+		set_seed(seed);
+		bool novice = yes_or_no(arbitrary_messages[WELCOME_YOU],
+		                        arbitrary_messages[CAVE_NEARBY],
+		                        arbitrary_messages[NO_MESSAGE]);
+		ZSET(game.novice, novice);
+		if (game.novice) {
+			ZSET(game.limit, NOVICELIMIT);
+		}
+		for (;;) {
+			if (!do_move()) {
+				continue;
+			}
+			if (!do_command()) {
+				break;
+			}
+		}
+		terminate(quitgame);
+	}
+	notice();
+
+	r->score = score_standing();
+	for (obj_t i = 1; i <= NOBJECTS; i++) {
+		r->score += score_object(i);
+	}
+	r->turns = game.turns;
+	memcpy(r->word, game.zzword, sizeof(r->word));
+	if (ranout) {
+		r->ending = ENDED_INPUT;
+	} else if (game.closed) {
+		r->ending = game.bonus == victory ? ENDED_WIN : ENDED_CLOSED;
+	} else if (died == game.turns) {
+		r->ending = ENDED_DEATH;
+	} else {
+		r->ending = ENDED_QUIT;
+	}
+	if (r->ending >= ENDED_DEATH) {
+		r->score += 4; // for not quitting, as terminate(endgame) gives
+	}
+}
+
+static void *worker(void *arg) {
+	/* Play blocks of seeds until there are none left. */
+	(void)arg;
+	memset(&settings, 0, sizeof(settings));
+	settings.silent = true;
+	settings.readline = script_readline;
+
+	for (;;) {
+		int32_t from = __atomic_fetch_add(&nextseed, BLOCK, __ATOMIC_RELAXED);
+		if (from > last) {
+			break;
+		}
+		for (int32_t seed = from; seed <= last && seed < from + BLOCK;
+		     seed++) {
+			play(seed, &results[seed - first]);
+		}
+	}
+	return NULL;
+}
+
+static int compare_int(const void *a, const void *b) {
+	int32_t x = *(const int32_t *)a, y = *(const int32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static int compare_word(const void *a, const void *b) {
+	return strcmp(a, b);
+}
+
+static void quantiles(const char *what, int32_t *v, size_t n) {
+	/* One line summing up n values, which get sorted. */
+	if (n == 0) {
+		printf("%-12s none\n", what);
+		return;
+	}
+	double sum = 0;
+	for (size_t i = 0; i < n; i++) {
+		sum += v[i];
+	}
+	qsort(v, n, sizeof(int32_t), compare_int);
+	printf("%-12s n %zu  min %d  p10 %d  median %d  p90 %d  max %d  "
+	       "mean %.1f\n",
+	       what, n, v[0], v[n / 10], v[n / 2], v[n - 1 - n / 10], v[n - 1],
+	       sum / n);
+}
+
+static void report(size_t n) {
+	/* Aggregate the results. */
+	int32_t *v = malloc(n * sizeof(int32_t));
+	char(*words)[TOKLEN + 1] = malloc(n * sizeof(*words));
+	size_t count[ENDINGS] = {0}, deaths[NDEATHS + 1] = {0};
+	size_t k;
+
+	printf("seeds %d-%d, %zu games\n", (int)first, (int)last, n);
+	for (k = 0; k < n; k++) {
+		v[k] = results[k].score;
+	}
+	quantiles("score", v, n);
+	for (k = 0; k < n; k++) {
+		v[k] = results[k].turns;
+	}
+	quantiles("turns", v, n);
+
+	for (k = 0; k < n; k++) {
+		count[results[k].ending]++;
+		deaths[results[k].deaths <= NDEATHS ? results[k].deaths
+		                                    : NDEATHS]++;
+	}
+	printf("%-12s", "ended");
+	for (int e = 0; e < ENDINGS; e++) {
+		printf(" %s %zu%s", endings[e], count[e],
+		       e < ENDINGS - 1 ? "," : "\n");
+	}
+	printf("%-12s", "deaths");
+	for (int d = 0; d <= NDEATHS; d++) {
+		printf(" %d: %zu%s", d, deaths[d], d < NDEATHS ? "," : "\n");
+	}
+
+	size_t m = 0;
+	for (k = 0; k < n; k++) {
+		if (results[k].death >= 0) {
+			v[m++] = results[k].death;
+		}
+	}
+	quantiles("first death", v, m);
+	m = 0;
+	for (k = 0; k < n; k++) {
+		if (results[k].dwarf >= 0) {
+			v[m++] = results[k].dwarf;
+		}
+	}
+	quantiles("first dwarf", v, m);
+
+	/* Magic words: how many distinct, and the commonest */
+	for (k = 0; k < n; k++) {
+		memcpy(words[k], results[k].word, sizeof(words[k]));
+	}
+	qsort(words, n, sizeof(words[0]), compare_word);
+	size_t distinct = 0, best = 0, run = 0;
+	const char *commonest = "";
+	for (k = 0; k < n; k++) {
+		run = k > 0 && strcmp(words[k], words[k - 1]) == 0 ? run + 1 : 1;
+		distinct += run == 1;
+		if (run > best) {
+			best = run;
+			commonest = words[k];
+		}
+	}
+	printf("%-12s %zu distinct, commonest %s (%zu seeds)\n", "magic word",
+	       distinct, commonest, best);
+	free(words);
+	free(v);
+}
+
+static bool read_script(const char *name) {
+	/* Load the script, a line per command. */
+	FILE *fp = fopen(name, "r");
+	char buf[LINESIZE];
+
+	if (fp == NULL) {
+		return false;
+	}
+	while (fgets(buf, sizeof(buf), fp) != NULL) {
+		buf[strcspn(buf, "\n")] = '\0';
+		lines = realloc(lines, (nlines + 1) * sizeof(char *));
+		lines[nlines++] = strdup(buf);
+	}
+	fclose(fp);
+	return true;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	bool list = false;
+	int ch;
+
+	first = 0;
+	last = LCG_M - 1;
+	while ((ch = getopt(argc, argv, "j:ls:")) != EOF) {
+		switch (ch) {
+		case 'j':
+			jobs = atol(optarg);
+			break;
+		case 'l':
+			list = true;
+			break;
+		case 's': {
+			long from, to;
+			int got = sscanf(optarg, "%ld-%ld", &from, &to);
+			if (got < 1 || from < 0 || from >= LCG_M ||
+			    (got == 2 && (to < from || to >= LCG_M))) {
+				fprintf(stderr, "%s: seeds run from 0 to %ld\n",
+				        argv[0], LCG_M - 1);
+				exit(EXIT_FAILURE);
+			}
+			first = from;
+			last = got == 2 ? to : from;
+			break;
+		}
+		default:
+			fprintf(stderr,
+			        "Usage: %s [-j threads] [-s first[-last]] [-l] "
+			        "script\n",
+			        argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "%s: one script, please\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+	if (!read_script(argv[optind])) {
+		perror(argv[optind]);
+		exit(EXIT_FAILURE);
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+
+	size_t n = (size_t)(last - first) + 1;
+	results = calloc(n, sizeof(struct result_t));
+	nextseed = first;
+	double started = now();
+	pthread_t *pool = calloc(jobs, sizeof(pthread_t));
+	for (long i = 0; i < jobs; i++) {
+		pthread_create(&pool[i], NULL, worker, NULL);
+	}
+	for (long i = 0; i < jobs; i++) {
+		pthread_join(pool[i], NULL);
+	}
+	free(pool);
+	double elapsed = now() - started;
+	fprintf(stderr, "%zu games in %.1f s, %.0f games/s on %ld threads\n", n,
+	        elapsed, elapsed > 0 ? n / elapsed : 0, jobs);
+
+	if (list) {
+		for (size_t k = 0; k < n; k++) {
+			const struct result_t *r = &results[k];
+			printf("%d %d %d %d %d %d %s %s\n", (int)(first + k),
+			       r->score, r->turns, r->deaths, r->death, r->dwarf,
+			       r->word, endings[r->ending]);
+		}
+	}
+	report(n);
+	return EXIT_SUCCESS;
+}
+
+/* end */
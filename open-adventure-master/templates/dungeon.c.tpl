@@ -3,6 +3,7 @@ SPDX-FileCopyrightText: Copyright Eric S. Raymond <esr@thyrsus.com>
 SPDX-License-Identifier: BSD-2-Clause
 */
 
+#include "advent.h"
 #include "{h_file}"
 
 const char* arbitrary_messages[] = {{
@@ -33,7 +34,7 @@ const hint_t hints[] = {{
 {hints}
 }};
 
-long conditions[] = {{
+const long conditions[] = {{
 {conditions}
 }};
 
@@ -56,4 +57,18 @@ const char *ignore = "{ignore}";
 /* Dwarf starting locations */
 const int dwarflocs[NDWARVES] = {{{dwarflocs}}};
 
+/* The game as it stands once initialised, before the seed is set.
+ * initialise() copies this and then calls set_seed(). */
+const struct game_t initial_game = {{
+    /*  Last dwarf is special (the pirate).  He always starts at his
+     *  chest's eventual location inside the maze. This loc is saved
+     *  in chloc for ref. The dead end in the other maze has its
+     *  loc stored in chloc2. */
+    .chloc = LOC_MAZEEND12, .chloc2 = LOC_DEADEND13, .abbnum = 5,
+    .clock1 = WARNTIME,     .clock2 = FLASHTIME,     .newloc = LOC_START,
+    .loc = LOC_START,       .limit = GAMELIMIT,      .foobar = WORD_EMPTY,
+    .conds = (1 << COND_HBASE),
+{initial_game}
+}};
+
 /* end */
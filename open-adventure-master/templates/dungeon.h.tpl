@@ -82,6 +82,7 @@ typedef struct {{
 }} class_t;
 
 typedef struct {{
+  const char* name;
   const int number;
   const int turns;
   const int penalty;
@@ -120,7 +121,7 @@ extern const class_t classes[];
 extern const turn_threshold_t turn_thresholds[];
 extern const obituary_t obituaries[];
 extern const hint_t hints[];
-extern long conditions[];
+extern const long conditions[];
 extern const motion_t motions[];
 extern const action_t actions[];
 extern const travelop_t travel[];
@@ -137,6 +138,7 @@ extern const char *ignore;
 #define NACTIONS  	{num_actions}
 #define NTRAVEL		{num_travel}
 #define NKEYS		{num_keys}
+#define NARBITRARY	{num_arbitrary}
 
 #define BIRD_ENDSTATE {bird_endstate}
 
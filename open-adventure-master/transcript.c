@@ -0,0 +1,104 @@
+/*
+ * Transcript hashing, enabled by advent -H.
+ *
+ * transcript_open() wraps the game's output stream in one that folds
+ * every byte written through it into a rolling FNV-1a hash on the way
+ * to the real destination, or drops it after hashing if there is none.
+ * Each time the game asks for input, and once more when the session
+ * ends, transcript_turn() appends a record of where things stand:
+ *
+ *	prompt turns offset outhash statehash
+ *
+ * prompt counts records from 0, turns is game.turns, offset is the
+ * number of bytes of output so far and outhash their hash (16 hex
+ * digits), and statehash is game_hash() of the game as it stands.
+ * Until the log's seed command or a restored save sets the RNG, the
+ * game holds a seed taken from the clock, so statehash is written as 0
+ * there; otherwise no two runs started in different seconds agree.
+ *
+ * Two replays of a log agree exactly as far as their records do, so
+ * comparing record files finds the first prompt at which a replay
+ * diverged without keeping either transcript; offset then says where
+ * in the text to start looking.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#define _GNU_SOURCE // for fopencookie()
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "advent.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static ssize_t hash_write(void *cookie, const char *buf, size_t size) {
+	struct transcript_t *tx = cookie;
+	uint64_t hash = tx->hash;
+
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ (unsigned char)buf[i]) * FNV_PRIME;
+	}
+	tx->hash = hash;
+	tx->offset += size;
+	if (tx->dest != NULL && fwrite(buf, 1, size, tx->dest) != size) {
+		return -1; // LCOV_EXCL_LINE
+	}
+	return size;
+}
+
+static int hash_close(void *cookie) {
+	/* The destination belongs to the caller; just push out what the
+	 * hashing stream handed it. */
+	struct transcript_t *tx = cookie;
+	return tx->dest != NULL ? fflush(tx->dest) : 0;
+}
+
+FILE *transcript_open(struct transcript_t *tx, FILE *dest, FILE *records) {
+	/* Start hashing a session's output.  Returns the stream the game
+	 * should write to, or NULL if one can't be made. */
+	cookie_io_functions_t io = {.write = hash_write, .close = hash_close};
+
+	memset(tx, 0, sizeof(*tx));
+	tx->dest = dest;
+	tx->records = records;
+	tx->hash = FNV_OFFSET;
+	tx->stream = fopencookie(tx, "w", io);
+	return tx->stream;
+}
+
+uint64_t game_hash(void) {
+	/* Hash of the whole of struct game_t, a word at a time.  Only
+	 * meaningful between builds with the same layout. */
+	const unsigned char *p = (const unsigned char *)&game;
+	uint64_t hash = FNV_OFFSET;
+	size_t i;
+
+	for (i = 0; i + sizeof(uint64_t) <= sizeof(game); i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, p + i, sizeof(word));
+		hash ^= word * 0x9e3779b97f4a7c15ULL;
+		hash = (hash << 27 | hash >> 37) * FNV_PRIME;
+	}
+	for (; i < sizeof(game); i++) {
+		hash = (hash ^ p[i]) * FNV_PRIME;
+	}
+	return hash ^ hash >> 32;
+}
+
+void transcript_turn(struct transcript_t *tx) {
+	/* Record the output and game state at this point; a no-op when
+	 * not hashing. */
+	if (tx == NULL) {
+		return;
+	}
+	fflush(tx->stream);
+	fprintf(tx->records, "%d %d %" PRIu64 " %016" PRIx64 " %016" PRIx64 "\n",
+	        tx->prompts++, (int)game.turns, tx->offset, tx->hash,
+	        tx->seeded ? game_hash() : 0);
+}
+
+/* end */
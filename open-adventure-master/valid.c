@@ -0,0 +1,205 @@
+/*
+ * The commands worth trying in the live game, as compact ids.
+ *
+ * An agent picking words at random spends most turns on "I don't know
+ * that word", "I see no ... here" and "There is no way to go that
+ * direction".  valid_actions() lists instead the motions the travel
+ * table has for game.loc (plus LOOK and, where it leads somewhere,
+ * BACK), the verbs that do something on their own, and each verb with
+ * each object action() would accept as here and that verb's handler in
+ * actions.c treats as more than a refusal.  Objects are found with
+ * HERE()/AT() and the same stand-ins action() allows (liquids, the urn's
+ * oil, the dwarf, the second rod and plant).
+ *
+ * Ids are laid out by the VALID_* macros in advent.h; valid_command()
+ * turns one back into words for the parser.  Listing the actions reads
+ * the travel entries for one location and tests each object once, so
+ * it is cheap enough to call every turn.
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdio.h>
+
+#include "advent.h"
+
+/* Verbs that take no object.  Those that guess one when it is left
+ * out are offered with the object instead. */
+static const int intransitives[] = {
+    NOTHING, QUIT, INVENTORY, BLAST, SCORE,  FEE,  FIE,
+    FOE,     FOO,  FUM,       BRIEF, LISTEN, PART,
+};
+
+/* Verbs with a handler for some objects */
+static const int transitives[] = {
+    CARRY, DROP, THROW, WAVE, LOCK, UNLOCK, LIGHT, EXTINGUISH, ATTACK,
+    FEED,  WAKE, POUR,  EAT,  DRINK, FILL,  RUB,   READ,  BREAK,   FLY,
+};
+
+static bool reachable(obj_t obj) {
+	/* Would action() take obj as being here?  Mirrors its tests. */
+	return HERE(obj) || (obj == DWARF && atdwrf(game.loc) > 0) ||
+	       (!game.closed &&
+	        ((LIQUID() == obj && HERE(BOTTLE)) || obj == LIQLOC(game.loc))) ||
+	       (obj == OIL && HERE(URN) &&
+	        game.objects[URN].prop != URN_EMPTY) ||
+	       (obj == PLANT && AT(PLANT2) &&
+	        game.objects[PLANT2].prop != PLANT_THIRSTY) ||
+	       (obj == ROD && HERE(ROD2));
+}
+
+static bool applies(verb_t verb, obj_t obj) {
+	/* Does the verb's handler do more than refuse obj? */
+	switch (verb) {
+	case CARRY:
+		return !TOTING(obj);
+	case DROP:
+		return TOTING(obj) || (obj == LIQUID() && TOTING(BOTTLE));
+	case THROW:
+	case WAVE:
+		return TOTING(obj);
+	case LOCK:
+	case UNLOCK:
+		return obj == CHAIN || obj == GRATE || obj == CLAM ||
+		       obj == OYSTER || obj == DOOR || obj == CAGE ||
+		       obj == KEYS;
+	case LIGHT:
+	case RUB:
+		return obj == LAMP || obj == URN;
+	case EXTINGUISH:
+		return obj == LAMP || obj == URN || obj == DRAGON ||
+		       obj == VOLCANO;
+	case ATTACK:
+	case EAT:
+		if (obj == BIRD || obj == CLAM || obj == OYSTER ||
+		    (verb == ATTACK ? obj == VEND : obj == FOOD)) {
+			return true;
+		}
+	/* FALLTHRU */
+	case FEED:
+		return obj == BIRD || obj == SNAKE || obj == DWARF ||
+		       obj == DRAGON || obj == TROLL || obj == BEAR ||
+		       obj == OGRE;
+	case WAKE:
+		return obj == DWARF && game.closed;
+	case POUR:
+		if (obj == BOTTLE) {
+			obj = LIQUID();
+		}
+		return (obj == WATER || obj == OIL) && TOTING(obj);
+	case DRINK:
+		return obj == WATER || obj == BLOOD;
+	case FILL:
+		return obj == BOTTLE || obj == VASE || obj == URN;
+	case READ:
+		return objects[obj].texts[0] != NULL && !IS_DARK_HERE();
+	case BREAK:
+		return obj == MIRROR || obj == VASE;
+	case FLY:
+		return obj == RUG;
+	default:
+		return false;
+	}
+}
+
+static bool can_go_back(void) {
+	/* Would BACK find a way, as playermove() looks for one? */
+	loc_t target = FORCED(game.oldloc) ? game.oldlc2 : game.oldloc;
+
+	if (CNDBIT(game.loc, COND_NOBACK) || target == game.loc) {
+		return false;
+	}
+	for (int kk = tkey[game.loc];; kk++) {
+		if (travel[kk].desttype == dest_goto) {
+			loc_t dest = travel[kk].destval;
+			if (dest == target ||
+			    (FORCED(dest) && travel[tkey[dest]].destval == target)) {
+				return true;
+			}
+		}
+		if (travel[kk].stop) {
+			return false;
+		}
+	}
+}
+
+size_t valid_actions(int *ids, size_t max) {
+	/* Fill ids with up to max commands worth trying now; return how
+	 * many there are. */
+	bool moved[NMOTIONS] = {false};
+	size_t n = 0;
+
+#define ADD(id)                                                                \
+	do {                                                                   \
+		if (n < max) {                                                 \
+			ids[n] = (id);                                         \
+		}                                                              \
+		n++;                                                           \
+	} while (0)
+	int kk = tkey[game.loc];
+	do {
+		moved[travel[kk].motion] = true;
+	} while (!travel[kk++].stop);
+	moved[HERE] = false;
+	moved[LOOK] = true;
+	moved[BACK] = can_go_back();
+	for (int m = 0; m < NMOTIONS; m++) {
+		if (moved[m] && motions[m].words.n > 0) {
+			ADD(VALID_MOTION(m));
+		}
+	}
+
+	for (size_t v = 0; v < sizeof(intransitives) / sizeof(intransitives[0]);
+	     v++) {
+		ADD(VALID_VERB(intransitives[v]));
+	}
+
+	for (obj_t obj = 1; obj <= NOBJECTS; obj++) {
+		if (objects[obj].words.n == 0 || !reachable(obj)) {
+			continue;
+		}
+		for (size_t v = 0;
+		     v < sizeof(transitives) / sizeof(transitives[0]); v++) {
+			if (applies(transitives[v], obj)) {
+				ADD(VALID_PAIR(transitives[v], obj));
+			}
+		}
+	}
+#undef ADD
+	return n;
+}
+
+bool valid_command(int id, char *buf, size_t size) {
+	/* Spell out a command id as the parser would take it. */
+	if (id < 0 || id >= VALID_IDS) {
+		return false;
+	}
+	if (id < VALID_VERB(0)) {
+		if (motions[id].words.n == 0) {
+			return false;
+		}
+		snprintf(buf, size, "%s", motions[id].words.strs[0]);
+		return true;
+	}
+	if (id < VALID_PAIR(0, 0)) {
+		verb_t verb = id - VALID_VERB(0);
+		if (actions[verb].words.n == 0) {
+			return false;
+		}
+		// The parser knows the magic word only by this game's spelling
+		snprintf(buf, size, "%s",
+		         verb == PART ? game.zzword : actions[verb].words.strs[0]);
+		return true;
+	}
+	verb_t verb = (id - VALID_PAIR(0, 0)) / (NOBJECTS + 1);
+	obj_t obj = (id - VALID_PAIR(0, 0)) % (NOBJECTS + 1);
+	if (actions[verb].words.n == 0 || objects[obj].words.n == 0) {
+		return false;
+	}
+	snprintf(buf, size, "%s %s", actions[verb].words.strs[0],
+	         objects[obj].words.strs[0]);
+	return true;
+}
+
+/* end */
@@ -0,0 +1,67 @@
+/*
+ * Incremental Zobrist hash of the live game state.
+ *
+ * The hash of a struct game_t is the XOR, over each eight-byte word of
+ * it, of a pseudo-random key chosen by the word's position and value.
+ * Changing a field therefore changes the hash by the keys of the words
+ * holding it before the write XORed with their keys after, which is
+ * what ZSET() applies around each write, so game_zobrist always holds
+ * the hash of game without the game ever being rescanned.  Equal states
+ * hash equally however they were reached, so solvers and replay buffers
+ * can use game_zobrist to find duplicates.
+ *
+ * Keys are computed rather than tabled, since a word can take any
+ * value.  Most fields lie within one word, so a write costs two key
+ * computations; a full recompute costs one per word.  The key and
+ * toggle functions live in advent.h so that ZSET() inlines them.
+ *
+ * Built with -DADVENT_ZOBRIST_CHECK (as "make debug" does),
+ * zobrist_check() recomputes the hash from scratch at every prompt and
+ * treats any difference as a bug, which catches a write that bypassed
+ * ZSET().
+ *
+ * SPDX-FileCopyrightText: (C) Eric S. Raymond <esr@thyrsus.com>
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <string.h>
+
+#include "advent.h"
+
+THREAD_LOCAL uint64_t game_zobrist;
+
+#define WORDS ((sizeof(struct game_t) + 7) / 8)
+
+uint64_t zobrist_full(const struct game_t *g) {
+	/* The hash of any game, computed from scratch. */
+	uint64_t hash = 0;
+
+	for (size_t w = 0; w < WORDS; w++) {
+		hash ^= zobrist_key(w, zobrist_word(g, w));
+	}
+	return hash;
+}
+
+void zobrist_rehash(void) {
+	/* Resynchronize after the live game was overwritten wholesale,
+	 * along with the attached observation if there is one. */
+	game_zobrist = zobrist_full(&game);
+	observe_rehash();
+}
+
+uint64_t zobrist_hash(void) {
+	/* The hash of the live game. */
+	zobrist_check();
+	return game_zobrist;
+}
+
+void zobrist_check(void) {
+	/* In checking builds, die if the hash has drifted from the state. */
+#if defined ADVENT_ZOBRIST_CHECK
+	if (game_zobrist != zobrist_full(&game)) {
+		BUG(ZOBRIST_HASH_OUT_OF_STEP_WITH_GAME_STATE); // LCOV_EXCL_LINE
+	}
+#endif
+}
+
+/* end */